@@ -0,0 +1,128 @@
+/* LICENSE
+ *
+ * Copyright © 2021 Blue-Maned_Hawk.  All rights reserved.
+ *
+ * This software should have come with a file called LICENSE.  In case of any difference between this comment and that file, that file is the authority.  (If you did not recieve that file, it's a violation of the license.  Please report it to me.)
+ *
+ * This project is copylefted.  You may freely use, distribute, and modify this software, to the extent permitted by law, so long as you do not attempt to claim such activities are condoned by the author, you distribute the license file with any distributions of this software, you release any modifications under a similar license, and you do not attempt to claim that modified software is the original software.
+ *
+ * This license does not apply to software created with the API of this software (thought it does apply to the API itself); it also does not apply to any rule files, all of which must be placed in the public domain.
+ *
+ * This software links to zlib, which is under the zlib license, available at https://www.zlib.net/zlib_license.html.
+ *
+ * This software dynamically links to SDL2, which is under a separate instance of the zlib license, available at https://libsdl.org/license.php.
+ *
+ * This software dynamically links to libgcrypt, which is under the GNU LGPL2.1+, available at https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=COPYING;h=ccbbaf61b794c7aaea10dffb486095fdc8f3a44a;hb=HEAD.
+ *
+ * This license does not apply to trademarks or patents.
+ *
+ * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
+
+/* This file is the half of the API that goes the other way:  subroutines that are part of Gake itself, which the programs call.  They're found by the dynamic linker when a program is loaded, which is why Gake is linked with `-rdynamic`.  Everything in here has to be safe to call from any number of program threads at once, and from an isolated program's process.
+ *
+ * A `struct gake_game` is just a board, and so is what `gake_simulate()` plays on.  Copying one only copies the occupancy grid and the live part of the snake, which is a few kilobytes even on a big board, so a program that searches can copy the game thousands of times a frame without having to write (and keep in step with) its own version of the rules.
+ *
+ * When reading this file, you are expected to have access to and generally understand the following documents:
+ * 	· Latest draft of C2x:  http://www.open-std.org/JTC1/SC22/WG14/www/docs/n2596.pdf
+ * 	· The Clang compiler user(?) manual:  https://clang.llvm.org/docs/UsersManual.html
+ * 	· The latest POSIX specification:  https://pubs.opengroup.org/onlinepubs/9699919799/mindex.html */
+
+#include "Board.h"
+#include "Trace.h"
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "../gake.h"
+
+struct gake_game {
+	struct board board;
+};
+
+/* The apples that spawn in a copy aren't the ones that will spawn in the real game; nothing a program is told can say where those will be.  They're still the same every time for the same state, though, so a search gives the same answer twice. */
+static uint64_t copy_seed(const struct gake_curstate * state)
+{
+	return (uint64_t)state->frame * 0x9e3779b97f4a7c15 ^ (uint64_t)((int64_t)state->head_y * state->width + state->head_x) << 32 ^ (uint64_t)((int64_t)state->apple_y * state->width + state->apple_x);
+}
+
+struct gake_game * gake_clone(const struct gake_curstate * state)
+{
+	struct gake_game * game = calloc(1, sizeof *game);
+	if (game == NULL)
+		return NULL;
+	if (!board_adopt(&game->board, state, copy_seed(state))){
+		free(game);
+		return NULL;
+	}
+	return game;
+}
+
+void gake_release(struct gake_game * game)
+{
+	if (game == NULL)
+		return;
+	board_free(&game->board);
+	free(game);
+}
+
+/* Just what this copy needs:  the grid and the snake as long as it is now, not every slot of the ring.  (The most that a snapshot could ever need is a whole board's worth of body, which is megabytes on a big board even when the snake is a few cells long.) */
+size_t gake_snapshot_size(const struct gake_game * game)
+{
+	return board_image_size(&game->board);
+}
+
+void gake_snapshot(const struct gake_game * game, void * blob)
+{
+	board_save(&game->board, blob);
+}
+
+/* Only goes back to `malloc()` if the snapshot was of a board of a different size.  The snapshot says how long the snake is, and `board_load()` checks that against `size` before it reads any of it, so a snapshot that's been cut short is turned down rather than read past. */
+_Bool gake_restore(struct gake_game * game, const void * blob, size_t size)
+{
+	return board_load(&game->board, blob, size);
+}
+
+_Bool gake_step(struct gake_game * game, enum gake_direction direction)
+{
+	return board_step(&game->board, direction);
+}
+
+/* The pointers in `state` are into `game`, so they only last until it's next stepped, restored, or released. */
+void gake_describe(const struct gake_game * game, struct gake_curstate * state)
+{
+	board_describe(&game->board, state, 1);
+	state->keys = "";
+}
+
+/* Each thread that simulates keeps one board to do it on, so that simulating only allocates the first time, or when the board changes size.  The threads that call programs stay around for as long as the programs do, so these are never freed. */
+static _Thread_local struct board scratch;
+
+_Bool gake_simulate(const struct gake_curstate * state, const struct gake_newstate * moves, size_t count, struct gake_result * result)
+{
+	*result = (struct gake_result){};
+	if (!board_adopt(&scratch, state, copy_seed(state)))
+		return 0;
+	size_t made = 0;
+	while (made < count && scratch.alive)
+		board_step(&scratch, moves[made++].direction);
+	uint32_t head = scratch.body[scratch.head];
+	*result = (struct gake_result){
+		.moves = made,
+		.alive = scratch.alive,
+		.apples = scratch.score,
+		.length = scratch.length,
+		.head_x = head % scratch.width,
+		.head_y = head / scratch.width
+	};
+	return 1;
+}
+
+/* See `Source/Trace.c`.  This never waits for anything, so a program can log from inside the frame that it's being timed on. */
+[[gnu::format(printf, 1, 2)]] void gake_log(const char * format, ...)
+{
+	va_list ap;
+	va_start(ap, format);
+	trace_vlog(format, ap);
+	va_end(ap);
+}
@@ -0,0 +1,167 @@
+/* LICENSE
+ *
+ * Copyright © 2021 Blue-Maned_Hawk.  All rights reserved.
+ *
+ * This software should have come with a file called LICENSE.  In case of any difference between this comment and that file, that file is the authority.  (If you did not recieve that file, it's a violation of the license.  Please report it to me.)
+ *
+ * This project is copylefted.  You may freely use, distribute, and modify this software, to the extent permitted by law, so long as you do not attempt to claim such activities are condoned by the author, you distribute the license file with any distributions of this software, you release any modifications under a similar license, and you do not attempt to claim that modified software is the original software.
+ *
+ * This license does not apply to software created with the API of this software (thought it does apply to the API itself); it also does not apply to any rule files, all of which must be placed in the public domain.
+ *
+ * This software links to zlib, which is under the zlib license, available at https://www.zlib.net/zlib_license.html.
+ *
+ * This software dynamically links to SDL2, which is under a separate instance of the zlib license, available at https://libsdl.org/license.php.
+ *
+ * This software dynamically links to libgcrypt, which is under the GNU LGPL2.1+, available at https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=COPYING;h=ccbbaf61b794c7aaea10dffb486095fdc8f3a44a;hb=HEAD.
+ *
+ * This license does not apply to trademarks or patents.
+ *
+ * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
+
+/* This file steps lots of independent boards in lockstep.  Each step is done in two halves:  first, working out where every head is going, which is the same arithmetic for every board and is laid out so that Clang can vectorize it (SSE or AVX2, depending on what it's told to target, or just plain scalar code otherwise); then, moving each snake, which touches each board's own grid and can't be.
+ *
+ * When reading this file, you are expected to have access to and generally understand the following documents:
+ * 	· Latest draft of C2x:  http://www.open-std.org/JTC1/SC22/WG14/www/docs/n2596.pdf
+ * 	· The Clang compiler user(?) manual:  https://clang.llvm.org/docs/UsersManual.html
+ * 	· The latest POSIX specification:  https://pubs.opengroup.org/onlinepubs/9699919799/mindex.html */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "Batch.h"
+#include "Board.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Rounded up to a whole cache line, since `aligned_alloc()` wants a multiple of the alignment. */
+static void * alloc_column(size_t count, size_t size)
+{
+	size_t bytes = (count * size + 63) & ~(size_t)63;
+	return aligned_alloc(64, bytes ? bytes : 64);
+}
+
+bool batch_init(struct batch * batch, size_t count, int width, int height, enum gake_topology topology, uint64_t first_seed, long long starve)
+{
+	*batch = (struct batch){
+		.count = count,
+		.width = width,
+		.height = height,
+		.topology = topology,
+		.starve = starve,
+		.boards = calloc(count, sizeof (struct board)),
+		.states = alloc_column(count, sizeof (struct gake_curstate)),
+		.head_x = alloc_column(count, sizeof (int32_t)),
+		.head_y = alloc_column(count, sizeof (int32_t)),
+		.direction = alloc_column(count, sizeof (int32_t)),
+		.next = alloc_column(count, sizeof (uint32_t)),
+		.blocked = alloc_column(count, sizeof (uint8_t)),
+		.alive = alloc_column(count, sizeof (uint8_t)),
+		.last_apple = alloc_column(count, sizeof (long long))
+	};
+	if (batch->boards == NULL || batch->states == NULL || batch->head_x == NULL || batch->head_y == NULL || batch->direction == NULL || batch->next == NULL || batch->blocked == NULL || batch->alive == NULL || batch->last_apple == NULL){
+		batch_free(batch);
+		return 0;
+	}
+	for (register size_t i = 0; i < count; i++){
+		batch->states[i] = (struct gake_curstate){ .keys = "" };
+		if (!board_init(&batch->boards[i], width, height, topology, first_seed + i)){
+			batch_free(batch);
+			return 0;
+		}
+		uint32_t head = batch->boards[i].body[batch->boards[i].head];
+		batch->head_x[i] = head % width;
+		batch->head_y[i] = head / width;
+		batch->direction[i] = batch->boards[i].direction;
+		batch->alive[i] = 1;
+		batch->last_apple[i] = 0;
+	}
+	batch->living = count;
+	return 1;
+}
+
+void batch_free(struct batch * batch)
+{
+	if (batch->boards != NULL){
+		for (register size_t i = 0; i < batch->count; i++)
+			board_free(&batch->boards[i]);
+	}
+	free(batch->boards);
+	free(batch->states);
+	free(batch->head_x);
+	free(batch->head_y);
+	free(batch->direction);
+	free(batch->next);
+	free(batch->blocked);
+	free(batch->alive);
+	free(batch->last_apple);
+	*batch = (struct batch){};
+}
+
+/* Fills in `states` for every board that's still alive.  The keys are always empty, since nobody's pressing any. */
+void batch_describe(struct batch * batch, bool deltas)
+{
+	for (register size_t i = 0; i < batch->count; i++){
+		if (batch->alive[i])
+			board_describe(&batch->boards[i], &batch->states[i], deltas);
+		else
+			batch->states[i].alive = 0;
+	}
+}
+
+/* The first half of the kernel, once for each topology, so that the topology is only looked at once per step instead of once per board. */
+#define BATCH_HEADS(name, letter)\
+	static void heads_ ## name(size_t count, int32_t width, int32_t height, const struct gake_newstate * moves, int32_t * restrict head_x, int32_t * restrict head_y, int32_t * restrict direction, uint32_t * restrict next, uint8_t * restrict blocked)\
+	{\
+		_Pragma("clang loop vectorize(enable) interleave(enable)")\
+		for (size_t i = 0; i < count; i++){\
+			int32_t d = board_turn(direction[i], moves[i].direction);\
+			int32_t x = head_x[i] + board_dx(d);\
+			int32_t y = head_y[i] + board_dy(d);\
+			blocked[i] = board_wrap_ ## name(&x, &y, &d, width, height);\
+			direction[i] = d;\
+			head_x[i] = x;\
+			head_y[i] = y;\
+			next[i] = (uint32_t)y * (uint32_t)width + (uint32_t)x;\
+		}\
+	}
+BOARD_TOPOLOGIES(BATCH_HEADS)
+
+/* `moves` has one entry per board, including the dead ones (whose entries are ignored).  Returns how many boards are still alive. */
+size_t batch_step(struct batch * batch, const struct gake_newstate * moves)
+{
+	const size_t count = batch->count;
+	switch (batch->topology){
+#define BATCH_HEADS_CASE(name, letter)\
+		case gake_ ## name:\
+			heads_ ## name(count, batch->width, batch->height, moves, batch->head_x, batch->head_y, batch->direction, batch->next, batch->blocked);\
+			break;
+		BOARD_TOPOLOGIES(BATCH_HEADS_CASE)
+	}
+	const int32_t * direction = batch->direction;
+	const uint32_t * next = batch->next;
+	const uint8_t * blocked = batch->blocked;
+
+	size_t living = 0;
+	for (register size_t i = 0; i < count; i++){
+		if (!batch->alive[i])
+			continue;
+		struct board * board = &batch->boards[i];
+		unsigned score = board->score;
+		board->moved = board_turn(board->direction, moves[i].direction);
+		board->direction = direction[i];
+		if (!board_move(board, next[i], blocked[i])){
+			batch->alive[i] = 0;
+			continue;
+		}
+		if (board->score != score){
+			batch->last_apple[i] = board->frames;
+		} else if (batch->starve != 0 && board->frames - batch->last_apple[i] > batch->starve){
+			board->alive = 0;
+			batch->alive[i] = 0;
+			continue;
+		}
+		living++;
+	}
+	batch->living = living;
+	return living;
+}
@@ -0,0 +1,54 @@
+/* LICENSE
+ *
+ * Copyright © 2021 Blue-Maned_Hawk.  All rights reserved.
+ *
+ * This software should have come with a file called LICENSE.  In case of any difference between this comment and that file, that file is the authority.  (If you did not recieve that file, it's a violation of the license.  Please report it to me.)
+ *
+ * This project is copylefted.  You may freely use, distribute, and modify this software, to the extent permitted by law, so long as you do not attempt to claim such activities are condoned by the author, you distribute the license file with any distributions of this software, you release any modifications under a similar license, and you do not attempt to claim that modified software is the original software.
+ *
+ * This license does not apply to software created with the API of this software (thought it does apply to the API itself); it also does not apply to any rule files, all of which must be placed in the public domain.
+ *
+ * This software links to zlib, which is under the zlib license, available at https://www.zlib.net/zlib_license.html.
+ *
+ * This software dynamically links to SDL2, which is under a separate instance of the zlib license, available at https://libsdl.org/license.php.
+ *
+ * This software dynamically links to libgcrypt, which is under the GNU LGPL2.1+, available at https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=COPYING;h=ccbbaf61b794c7aaea10dffb486095fdc8f3a44a;hb=HEAD.
+ *
+ * This license does not apply to trademarks or patents.
+ *
+ * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "Board.h"
+#include "../gake.h"
+
+/* A batch is a lot of independent boards that are all stepped together.  The values the step kernel touches on every board every frame are kept as a structure of arrays, so that the first half of the kernel is straight-line arithmetic across the whole batch; each board's occupancy grid and body stay in `boards`. */
+struct batch {
+	size_t count;
+	size_t living;
+	int width;
+	int height;
+	enum gake_topology topology;
+	long long starve; /* A board dies after this many frames without eating.  0 means never. */
+	struct board * boards;
+	struct gake_curstate * states; /* One per board, for handing to programs. */
+	int32_t * head_x;
+	int32_t * head_y;
+	int32_t * direction;
+	uint32_t * next;
+	uint8_t * blocked;
+	uint8_t * alive;
+	long long * last_apple;
+};
+
+extern bool batch_init(struct batch * batch, size_t count, int width, int height, enum gake_topology topology, uint64_t first_seed, long long starve);
+extern void batch_free(struct batch * batch);
+extern void batch_describe(struct batch * batch, bool deltas);
+extern size_t batch_step(struct batch * batch, const struct gake_newstate * moves);
+
+#endif/*ndef BATCH_H*/
@@ -0,0 +1,228 @@
+/* LICENSE
+ *
+ * Copyright © 2021 Blue-Maned_Hawk.  All rights reserved.
+ *
+ * This software should have come with a file called LICENSE.  In case of any difference between this comment and that file, that file is the authority.  (If you did not recieve that file, it's a violation of the license.  Please report it to me.)
+ *
+ * This project is copylefted.  You may freely use, distribute, and modify this software, to the extent permitted by law, so long as you do not attempt to claim such activities are condoned by the author, you distribute the license file with any distributions of this software, you release any modifications under a similar license, and you do not attempt to claim that modified software is the original software.
+ *
+ * This license does not apply to software created with the API of this software (thought it does apply to the API itself); it also does not apply to any rule files, all of which must be placed in the public domain.
+ *
+ * This software links to zlib, which is under the zlib license, available at https://www.zlib.net/zlib_license.html.
+ *
+ * This software dynamically links to SDL2, which is under a separate instance of the zlib license, available at https://libsdl.org/license.php.
+ *
+ * This software dynamically links to libgcrypt, which is under the GNU LGPL2.1+, available at https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=COPYING;h=ccbbaf61b794c7aaea10dffb486095fdc8f3a44a;hb=HEAD.
+ *
+ * This license does not apply to trademarks or patents.
+ *
+ * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
+
+#ifndef BINLOG_H
+#define BINLOG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* A binary log (see `gake -L`) is this header, then one entry after another.  Instead of the text of each message, an entry has the number of the format string that it was logged with and the arguments as they were passed, so logging costs the same however long the message would have been, and the text is only made when someone reads it.  Each format string is written once, in an entry of its own, before the first message that uses it.  Everything is in the byte order of the machine that wrote the log.  `Tools/LogRead.c` reads them. */
+struct binlog_header {
+	char magic[8]; /* "GAKEBLG" */
+	uint32_t version;
+	uint32_t padding;
+	int64_t realtime_ns; /* `CLOCK_REALTIME` and `CLOCK_MONOTONIC` when the log was started, for turning the times of the entries into times of day. */
+	int64_t monotonic_ns;
+};
+
+enum binlog_kind {
+	bk_message = 0,
+	bk_format = 1 /* `length` bytes of format string, without the terminator. */
+};
+
+/* Messages that couldn't be kept as arguments (because there were too many of them, or the format had something like `%n` in it) are kept as text instead, under this format. */
+#define BINLOG_TEXT UINT32_MAX
+
+struct binlog_entry {
+	int64_t time_ns; /* `CLOCK_MONOTONIC`. */
+	uint32_t format;
+	uint16_t length; /* How many bytes come after this. */
+	uint8_t kind;
+	int8_t priority; /* `enum log_priority` and `enum log_category`. */
+	uint8_t category;
+	uint8_t padding[7];
+};
+
+/* The most arguments that a format can take and still be kept as arguments. */
+#define BINLOG_MAX_ARGUMENTS 32
+
+/* Fills `types` with one letter for each argument that `format` takes, and a terminator:  `i` for an `int` (4 bytes), `l` for anything 64-bit that's an integer (8 bytes), `d` for a `double` (8 bytes), `L` for a `long double` (16 bytes), `p` for a pointer (8 bytes), and `s` for a string (a 16-bit length, then that many bytes).  A width or precision of `*` is an `int` of its own.  Returns 0 if the format can't be kept this way. */
+static inline bool binlog_types(const char * format, char types[static BINLOG_MAX_ARGUMENTS + 1])
+{
+	int count = 0;
+	for (const char * at = format; *at != '\0'; at++){
+		if (*at != '%')
+			continue;
+		if (*++at == '%')
+			continue;
+		while (*at != '\0' && strchr("-+ #0'", *at) != NULL)
+			at++;
+		if (*at == '*'){
+			if (count == BINLOG_MAX_ARGUMENTS)
+				return 0;
+			types[count++] = 'i';
+			at++;
+		}
+		while (*at >= '0' && *at <= '9')
+			at++;
+		if (*at == '.'){
+			at++;
+			if (*at == '*'){
+				if (count == BINLOG_MAX_ARGUMENTS)
+					return 0;
+				types[count++] = 'i';
+				at++;
+			}
+			while (*at >= '0' && *at <= '9')
+				at++;
+		}
+		char size = 'i';
+		for (; *at != '\0' && strchr("hlLzjt", *at) != NULL; at++)
+			size = *at == 'h' ? size : *at == 'L' ? 'L' : 'l';
+		char type;
+		switch (*at){
+		case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+			type = size == 'L' ? '\0' : size;
+			break;
+		case 'c':
+			type = size == 'i' ? 'i' : '\0';
+			break;
+		case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+			type = size == 'L' ? 'L' : 'd';
+			break;
+		case 's':
+			type = size == 'i' ? 's' : '\0';
+			break;
+		case 'p':
+			type = 'p';
+			break;
+		default:
+			type = '\0'; /* `%n`, wide characters, and anything else. */
+			break;
+		}
+		if (type == '\0' || count == BINLOG_MAX_ARGUMENTS)
+			return 0;
+		types[count++] = type;
+	}
+	types[count] = '\0';
+	return 1;
+}
+
+/* The opposite of packing the arguments:  writes `format` into `out` with the arguments in `arguments`, which are `length` bytes of what `types` says.  If the arguments run out early (because they didn't all fit), each missing one is written as `?`.  Every 64-bit integer is passed to `snprintf()` as a `long long`, which is the same as the rest of them on every platform that Gake runs on.  Returns how long the text is, which is always less than `room`. */
+static inline size_t binlog_format(char * out, size_t room, const char * format, const char * types, const uint8_t * arguments, size_t length)
+{
+	size_t used = 0, read = 0;
+	const char * at = format;
+	while (*at != '\0' && used + 1 < room){
+		if (*at != '%' || at[1] == '%'){
+			out[used++] = *at;
+			at += *at == '%' ? 2 : 1;
+			continue;
+		}
+		/* The conversion on its own, so that it can be given to `snprintf()` with just its own arguments. */
+		char spec[32];
+		size_t spec_length = strcspn(at + 1, "diouxXcfFeEgGaAsp") + 2;
+		if (spec_length >= sizeof spec || at[spec_length - 1] == '\0')
+			break;
+		memcpy(spec, at, spec_length);
+		spec[spec_length] = '\0';
+		at += spec_length;
+
+		int stars[2], star_count = 0;
+		bool missing = 0;
+		for (const char * c = spec; *c != '\0'; c++){
+			if (*c != '*')
+				continue;
+			if (*types != 'i' || read + sizeof (int32_t) > length){
+				missing = 1;
+				break;
+			}
+			int32_t star;
+			memcpy(&star, arguments + read, sizeof star);
+			read += sizeof star;
+			types++;
+			stars[star_count++] = star;
+		}
+		char * to = out + used;
+		size_t left = room - used;
+		int written = -1;
+#define BINLOG_PRINT(value) (star_count == 0 ? snprintf(to, left, spec, value) : star_count == 1 ? snprintf(to, left, spec, stars[0], value) : snprintf(to, left, spec, stars[0], stars[1], value))
+		switch (missing || *types == '\0' ? '\0' : *types++){
+		case 'i':
+			if (read + sizeof (int32_t) <= length){
+				int32_t value;
+				memcpy(&value, arguments + read, sizeof value);
+				read += sizeof value;
+				written = BINLOG_PRINT(value);
+			}
+			break;
+		case 'l':
+			if (read + sizeof (int64_t) <= length){
+				long long value;
+				memcpy(&value, arguments + read, sizeof value);
+				read += sizeof value;
+				written = BINLOG_PRINT(value);
+			}
+			break;
+		case 'd':
+			if (read + sizeof (double) <= length){
+				double value;
+				memcpy(&value, arguments + read, sizeof value);
+				read += sizeof value;
+				written = BINLOG_PRINT(value);
+			}
+			break;
+		case 'L':
+			if (read + sizeof (long double) <= length){
+				long double value;
+				memcpy(&value, arguments + read, sizeof value);
+				read += sizeof value;
+				written = BINLOG_PRINT(value);
+			}
+			break;
+		case 'p':
+			if (read + sizeof (uint64_t) <= length){
+				uint64_t value;
+				memcpy(&value, arguments + read, sizeof value);
+				read += sizeof value;
+				written = BINLOG_PRINT((void *)(uintptr_t)value);
+			}
+			break;
+		case 's':
+			if (read + sizeof (uint16_t) <= length){
+				uint16_t string_length;
+				memcpy(&string_length, arguments + read, sizeof string_length);
+				if (read + sizeof string_length + string_length <= length){
+					char value[string_length + 1];
+					memcpy(value, arguments + read + sizeof string_length, string_length);
+					value[string_length] = '\0';
+					read += sizeof string_length + string_length;
+					written = BINLOG_PRINT(value);
+				}
+			}
+			break;
+		}
+#undef BINLOG_PRINT
+		if (written < 0){
+			out[used++] = '?';
+			read = length;
+		} else {
+			used += (size_t)written < left ? (size_t)written : left - 1;
+		}
+	}
+	out[used] = '\0';
+	return used;
+}
+
+#endif/*ndef BINLOG_H*/
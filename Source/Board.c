@@ -0,0 +1,709 @@
+/* LICENSE
+ *
+ * Copyright © 2021 Blue-Maned_Hawk.  All rights reserved.
+ *
+ * This software should have come with a file called LICENSE.  In case of any difference between this comment and that file, that file is the authority.  (If you did not recieve that file, it's a violation of the license.  Please report it to me.)
+ *
+ * This project is copylefted.  You may freely use, distribute, and modify this software, to the extent permitted by law, so long as you do not attempt to claim such activities are condoned by the author, you distribute the license file with any distributions of this software, you release any modifications under a similar license, and you do not attempt to claim that modified software is the original software.
+ *
+ * This license does not apply to software created with the API of this software (thought it does apply to the API itself); it also does not apply to any rule files, all of which must be placed in the public domain.
+ *
+ * This software links to zlib, which is under the zlib license, available at https://www.zlib.net/zlib_license.html.
+ *
+ * This software dynamically links to SDL2, which is under a separate instance of the zlib license, available at https://libsdl.org/license.php.
+ *
+ * This software dynamically links to libgcrypt, which is under the GNU LGPL2.1+, available at https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=COPYING;h=ccbbaf61b794c7aaea10dffb486095fdc8f3a44a;hb=HEAD.
+ *
+ * This license does not apply to trademarks or patents.
+ *
+ * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
+
+/* This file is the simulation core of Gake:  the board, the snake, the apples, and the subroutine that advances all of them by one frame.  Nothing in here knows about SDL, so it can be driven as fast as the CPU allows by the headless mode, and the GUI is just one more thing that looks at it.
+ *
+ * When reading this file, you are expected to have access to and generally understand the following documents:
+ * 	· Latest draft of C2x:  http://www.open-std.org/JTC1/SC22/WG14/www/docs/n2596.pdf
+ * 	· The Clang compiler user(?) manual:  https://clang.llvm.org/docs/UsersManual.html
+ * 	· The latest POSIX specification:  https://pubs.opengroup.org/onlinepubs/9699919799/mindex.html */
+
+#include "Board.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+static const unsigned start_length = 4; /* Or one less than the width of the board, if that's shorter, so that it fits. */
+
+/* Each `board_init()` takes the next one of these for the top half of the board's epoch, and loading a board or moving its body to a bigger ring bumps the bottom half, so no two setups of any board ever share an epoch. */
+static _Atomic uint32_t epochs = 1;
+
+/* This is splitmix64.  It doesn't need to be good, it just needs to be fast and the same everywhere, so that a seed always gives the same game. */
+static uint64_t next_random(uint64_t * state)
+{
+	uint64_t z = (*state += 0x9e3779b97f4a7c15);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+	return z ^ (z >> 31);
+}
+
+/* Each chunk has one more word after its rows, which isn't part of the grid:  how many of its cells are occupied, in the bottom half, and where it is in `chunk_list`, in the top half.  A chunk is freed as soon as the snake leaves it, so a board only ever has the chunks that the snake is in. */
+#define CHUNK_WORDS (BOARD_CHUNK_SIDE + 1)
+
+static uint32_t chunk_of(const struct board * board, uint32_t cell)
+{
+	return (cell / board->width / BOARD_CHUNK_SIDE) * board->chunk_columns + cell % board->width / BOARD_CHUNK_SIDE;
+}
+
+/* Returns chunk `index`, making it if it isn't there yet, or NULL if there's no memory for it. */
+static uint64_t * make_chunk(struct board * board, uint32_t index)
+{
+	if (board->chunks[index] != NULL)
+		return board->chunks[index];
+	if (board->chunk_count == board->chunk_room){
+		uint32_t room = board->chunk_room ? board->chunk_room * 2 : 16;
+		uint32_t * list = realloc(board->chunk_list, room * sizeof (uint32_t));
+		if (list == NULL)
+			return NULL;
+		board->chunk_list = list;
+		board->chunk_room = room;
+	}
+	uint64_t * chunk = calloc(CHUNK_WORDS, sizeof (uint64_t));
+	if (chunk == NULL)
+		return NULL;
+	chunk[BOARD_CHUNK_SIDE] = (uint64_t)board->chunk_count << 32;
+	board->chunk_list[board->chunk_count++] = index;
+	return board->chunks[index] = chunk;
+}
+
+/* Frees chunk `index`, moving the last one in `chunk_list` into its place there. */
+static void drop_chunk(struct board * board, uint32_t index)
+{
+	uint64_t * chunk = board->chunks[index];
+	uint32_t place = chunk[BOARD_CHUNK_SIDE] >> 32;
+	uint32_t last = board->chunk_list[--board->chunk_count];
+	board->chunk_list[place] = last;
+	board->chunks[last][BOARD_CHUNK_SIDE] = (board->chunks[last][BOARD_CHUNK_SIDE] & UINT32_MAX) | (uint64_t)place << 32;
+	free(chunk);
+	board->chunks[index] = NULL;
+}
+
+/* Returns 0 if the cell is in a chunk that there's no memory for. */
+static inline bool occupy(struct board * board, uint32_t cell)
+{
+	if (board->occupancy != NULL){
+		board->occupancy[cell >> 6] |= (uint64_t)1 << (cell & 63);
+		return 1;
+	}
+	uint64_t * chunk = make_chunk(board, chunk_of(board, cell));
+	if (chunk == NULL)
+		return 0;
+	chunk[cell / board->width % BOARD_CHUNK_SIDE] |= (uint64_t)1 << (cell % board->width % BOARD_CHUNK_SIDE);
+	chunk[BOARD_CHUNK_SIDE]++;
+	return 1;
+}
+
+/* Only ever called on cells that are occupied, so the chunk is always there. */
+static inline void vacate(struct board * board, uint32_t cell)
+{
+	if (board->occupancy != NULL){
+		board->occupancy[cell >> 6] &= ~((uint64_t)1 << (cell & 63));
+		return;
+	}
+	uint32_t index = chunk_of(board, cell);
+	uint64_t * chunk = board->chunks[index];
+	chunk[cell / board->width % BOARD_CHUNK_SIDE] &= ~((uint64_t)1 << (cell % board->width % BOARD_CHUNK_SIDE));
+	if ((uint32_t)--chunk[BOARD_CHUNK_SIDE] == 0)
+		drop_chunk(board, index);
+}
+
+static uint32_t chunk_rows(int height)
+{
+	return (height + BOARD_CHUNK_SIDE - 1) / BOARD_CHUNK_SIDE;
+}
+
+static uint32_t chunk_columns(int width)
+{
+	return (width + BOARD_CHUNK_SIDE - 1) / BOARD_CHUNK_SIDE;
+}
+
+/* The same as the end of `spawn_apple()`, but a chunk at a time, and a chunk that isn't there is all free. */
+static void spawn_apple_chunked(struct board * board)
+{
+	uint32_t total = board->chunk_columns * chunk_rows(board->height);
+	uint32_t chunk = next_random(&board->rng) % total;
+	for (;;){
+		uint32_t left = chunk % board->chunk_columns * BOARD_CHUNK_SIDE;
+		uint32_t top = chunk / board->chunk_columns * BOARD_CHUNK_SIDE;
+		const uint64_t * rows = board->chunks[chunk];
+		uint64_t inside = board->width - left < BOARD_CHUNK_SIDE ? ((uint64_t)1 << (board->width - left)) - 1 : ~(uint64_t)0;
+		for (register uint32_t row = 0; row < BOARD_CHUNK_SIDE && top + row < (uint32_t)board->height; row++){
+			uint64_t free_bits = (rows == NULL ? ~(uint64_t)0 : ~rows[row]) & inside;
+			if (free_bits != 0){
+				board->apple = (top + row) * board->width + left + __builtin_ctzll(free_bits);
+				return;
+			}
+		}
+		chunk = (chunk + 1) % total;
+	}
+}
+
+static void spawn_apple(struct board * board)
+{
+	uint32_t cells = (uint32_t)board->width * board->height;
+	if (board->length >= cells){
+		board->apple = UINT32_MAX;
+		return;
+	}
+	/* Guessing is fast while the board is mostly empty; once it fills up, look for the next word from a random spot that has a free cell in it. */
+	for (register int i = 0; i < 64; i++){
+		uint32_t guess = next_random(&board->rng) % cells;
+		if (!board_occupied(board, guess)){
+			board->apple = guess;
+			return;
+		}
+	}
+	if (board->occupancy == NULL){
+		spawn_apple_chunked(board);
+		return;
+	}
+	uint32_t words = (cells + 63) / 64;
+	uint32_t word = (next_random(&board->rng) % cells) >> 6;
+	for (;;){
+		uint64_t free_bits = ~board->occupancy[word];
+		if (word == words - 1 && cells % 64 != 0)
+			free_bits &= ((uint64_t)1 << (cells % 64)) - 1;
+		if (free_bits != 0){
+			board->apple = word * 64 + __builtin_ctzll(free_bits);
+			return;
+		}
+		word = (word + 1) % words;
+	}
+}
+
+/* A flat board's ring has room for every cell, so it never has to grow; a chunked board's starts at this and doubles. */
+static const uint32_t chunked_start_slots = 256;
+
+/* How big the ring of a flat board is. */
+static uint32_t flat_slots(uint32_t cells)
+{
+	uint32_t capacity = 1;
+	while (capacity < cells)
+		capacity <<= 1;
+	return capacity;
+}
+
+#define BOARD_STEPPER(name, letter)\
+	static bool step_ ## name(struct board * board, enum gake_direction direction)\
+	{\
+		if (!board->alive)\
+			return 0;\
+		int32_t turned = board_turn(board->direction, direction);\
+		board->moved = turned;\
+		uint32_t head = board->body[board->head];\
+		int32_t x = head % board->width + board_dx(turned);\
+		int32_t y = head / board->width + board_dy(turned);\
+		bool blocked = board_wrap_ ## name(&x, &y, &turned, board->width, board->height);\
+		board->direction = turned;\
+		return board_move(board, (uint32_t)y * board->width + x, blocked);\
+	}
+BOARD_TOPOLOGIES(BOARD_STEPPER)
+
+#define BOARD_STEPPER_ENTRY(name, letter) [gake_ ## name] = step_ ## name,
+static board_stepper * const steppers[] = { BOARD_TOPOLOGIES(BOARD_STEPPER_ENTRY) };
+
+#define BOARD_WRAP_ENTRY(name, letter) [gake_ ## name] = board_wrap_ ## name,
+static bool (* const wraps[])(int32_t * x, int32_t * y, int32_t * direction, int32_t width, int32_t height) = { BOARD_TOPOLOGIES(BOARD_WRAP_ENTRY) };
+
+#define BOARD_NAME_ENTRY(name, letter) [gake_ ## name] = { #name, letter },
+static const struct {
+	const char * name;
+	char letter;
+} topologies[] = { BOARD_TOPOLOGIES(BOARD_NAME_ENTRY) };
+
+const char * board_topology_name(enum gake_topology topology)
+{
+	return topology <= gake_sphere ? topologies[topology].name : "unknown";
+}
+
+/* Takes either the whole name or Golly's letter for it. */
+bool board_topology_named(const char * name, enum gake_topology * topology)
+{
+	for (register unsigned i = 0; i < sizeof topologies / sizeof *topologies; i++){
+		if (strcmp(name, topologies[i].name) == 0 || (name[0] == topologies[i].letter && name[1] == '\0')){
+			*topology = i;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* A neighbour table has four entries for each cell, one for each direction (starting from `gake_up`), saying where the head goes from there:  the cell, shifted left by 3, with the direction it's then going in, or `UINT32_MAX` for a wall.  That takes the division and the edges out of every step, and for a small board, the table is small enough to stay in the cache. */
+struct neighbour_table {
+	struct neighbour_table * next;
+	int width;
+	int height;
+	enum gake_topology topology;
+	uint32_t entries[];
+};
+
+static struct neighbour_table * tables = NULL;
+static pthread_mutex_t tables_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Finds or makes the table for boards of this size and topology.  Returns NULL if there's no memory for it. */
+static const uint32_t * neighbour_table(int width, int height, enum gake_topology topology)
+{
+	pthread_mutex_lock(&tables_lock);
+	struct neighbour_table * table = tables;
+	while (table != NULL && (table->width != width || table->height != height || table->topology != topology))
+		table = table->next;
+	if (table == NULL && (table = malloc(sizeof *table + (size_t)width * height * 4 * sizeof (uint32_t))) != NULL){
+		*table = (struct neighbour_table){ .next = tables, .width = width, .height = height, .topology = topology };
+		for (register uint32_t cell = 0; cell < (uint32_t)width * height; cell++){
+			for (register int32_t direction = gake_up; direction <= gake_right; direction++){
+				int32_t x = cell % width + board_dx(direction);
+				int32_t y = cell / width + board_dy(direction);
+				int32_t turned = direction;
+				bool blocked = wraps[topology](&x, &y, &turned, width, height);
+				table->entries[cell * 4 + direction - gake_up] = blocked ? UINT32_MAX : ((uint32_t)y * width + x) << 3 | turned;
+			}
+		}
+		tables = table;
+	}
+	pthread_mutex_unlock(&tables_lock);
+	return table != NULL ? table->entries : NULL;
+}
+
+static bool step_table(struct board * board, enum gake_direction direction)
+{
+	if (!board->alive)
+		return 0;
+	int32_t turned = board_turn(board->direction, direction);
+	board->moved = turned;
+	uint32_t entry = board->neighbours[board->body[board->head] * 4 + turned - gake_up];
+	board->direction = entry == UINT32_MAX ? turned : (int32_t)(entry & 7);
+	return board_move(board, entry >> 3, entry == UINT32_MAX);
+}
+
+/* Small boards step through a neighbour table if there's memory for one, and everything else uses the stepper for its topology. */
+static void pick_stepper(struct board * board)
+{
+	board->step = steppers[board->topology];
+	board->neighbours = NULL;
+	if ((uint32_t)board->width * board->height <= BOARD_TABLE_CELLS && (board->neighbours = neighbour_table(board->width, board->height, board->topology)) != NULL)
+		board->step = step_table;
+}
+
+/* For a board that's been loaded over.  `resize()` only frees `board` (and so forgets how it steps) when the size changes, so a board that keeps being loaded with the same size and topology doesn't look for its table every time. */
+static void set_topology(struct board * board, enum gake_topology topology)
+{
+	if (board->step != NULL && board->topology == topology)
+		return;
+	board->topology = topology;
+	pick_stepper(board);
+}
+
+bool board_init(struct board * board, int width, int height, enum gake_topology topology, uint64_t seed)
+{
+	*board = (struct board){};
+	if (!board_size_ok(width, height) || !board_topology_ok(topology, width, height))
+		return 0;
+	uint32_t cells = (uint32_t)width * height;
+	bool chunked = cells > BOARD_FLAT_CELLS;
+	uint32_t capacity = chunked ? chunked_start_slots : flat_slots(cells);
+	*board = (struct board){
+		.width = width,
+		.height = height,
+		.occupancy = chunked ? NULL : calloc((cells + 63) / 64, sizeof (uint64_t)),
+		.chunks = chunked ? calloc((size_t)chunk_columns(width) * chunk_rows(height), sizeof (uint64_t *)) : NULL,
+		.chunk_columns = chunked ? chunk_columns(width) : 0,
+		.body = malloc(capacity * sizeof (uint32_t)),
+		.mask = capacity - 1,
+		.direction = gake_right,
+		.moved = gake_right,
+		.topology = topology,
+		.rng = seed,
+		.alive = 1,
+		.epoch = (uint64_t)atomic_fetch_add_explicit(&epochs, 1, memory_order_relaxed) << 32
+	};
+	if ((board->occupancy == NULL && board->chunks == NULL) || board->body == NULL){
+		board_free(board);
+		return 0;
+	}
+	/* Like in Google Snake, the snake starts on the left side of the middle row, facing right. */
+	unsigned length = width > (int)start_length ? start_length : (unsigned)width - 1;
+	for (register unsigned i = 0; i < length; i++){
+		uint32_t cell = (uint32_t)(height / 2) * width + 1 + i;
+		board->body[i] = cell;
+		if (!occupy(board, cell)){
+			board_free(board);
+			return 0;
+		}
+	}
+	board->head = length - 1;
+	board->length = length;
+	pick_stepper(board);
+	spawn_apple(board);
+	return 1;
+}
+
+static void free_chunks(struct board * board)
+{
+	for (register uint32_t i = 0; i < board->chunk_count; i++)
+		free(board->chunks[board->chunk_list[i]]);
+	board->chunk_count = 0;
+	free(board->chunks);
+	free(board->chunk_list);
+	board->chunks = NULL;
+	board->chunk_list = NULL;
+	board->chunk_room = 0;
+}
+
+void board_free(struct board * board)
+{
+	free(board->occupancy);
+	free_chunks(board);
+	free(board->body);
+	board->occupancy = NULL;
+	board->body = NULL;
+	board->step = NULL;
+	board->neighbours = NULL;
+	board->alive = 0;
+}
+
+/* Returns whether the snake is still alive afterwards.  Which version this calls was picked when the board was set up, so nothing in here has to check the topology.  A board that's been freed (which `board_load()` does when it fails) is dead and has no stepper, so that has to be checked here rather than in the steppers. */
+bool board_step(struct board * board, enum gake_direction direction)
+{
+	if (!board->alive)
+		return 0;
+	return board->step(board, direction);
+}
+
+/* Doubles the ring of a chunked board, straightening it out so that the tail is at the start.  A snake that would need more than 2³¹ slots can't grow any more. */
+static bool grow_body(struct board * board)
+{
+	uint32_t slots = board->mask + 1;
+	if (slots >= (uint32_t)1 << 31)
+		return 0;
+	uint32_t * body = malloc(slots * 2 * sizeof (uint32_t));
+	if (body == NULL)
+		return 0;
+	uint32_t tail = (board->head - board->length + 1) & board->mask;
+	uint32_t first = slots - tail < board->length ? slots - tail : board->length;
+	memcpy(body, &board->body[tail], first * sizeof (uint32_t));
+	memcpy(&body[first], board->body, (board->length - first) * sizeof (uint32_t));
+	free(board->body);
+	board->body = body;
+	board->mask = slots * 2 - 1;
+	board->head = board->length - 1;
+	board->epoch++; /* Every slot of the body has moved. */
+	return 1;
+}
+
+/* Moves the head into `next`, which has already been worked out (by `board_step()` or by the batch kernel), and deals with whatever happens.  `blocked` means that the snake ran into the edge of the board.  On a chunked board, running out of memory for the snake ends the game, the same as running into a wall. */
+bool board_move(struct board * board, uint32_t next, bool blocked)
+{
+	uint32_t changes = 0; /* Counted here rather than in the board, so that the compiler doesn't have to keep reloading it. */
+	board->frames++;
+	board->change_count = 0;
+	if (blocked){
+		board->alive = 0;
+		return 0;
+	}
+
+	bool eating = next == board->apple;
+	/* Only a chunked board's ring can ever be full, since a flat one has room for every cell, and it can only be outgrown by eating. */
+	if (eating && board->length == board->mask + 1 && !grow_body(board)){
+		board->alive = 0;
+		return 0;
+	}
+	/* The tail moves on at the same time as the head does, so unless the snake is eating, the head can go where the tail was, and that cell just stays occupied.  Nothing is changed until the move is known to be all right, so a snake that dies is left as it was. */
+	uint32_t tail = board_segment(board, 0);
+	bool into_tail = !eating && next == tail;
+	if (!into_tail && (board_occupied(board, next) || !occupy(board, next))){
+		board->alive = 0;
+		return 0;
+	}
+	if (!eating){
+		if (!into_tail)
+			vacate(board, tail);
+		board->changes[changes++] = (struct gake_delta){ tail, gake_tail_removed };
+		board->length--;
+	}
+	board->head = (board->head + 1) & board->mask;
+	board->body[board->head] = next;
+	board->length++;
+	board->changes[changes++] = (struct gake_delta){ next, gake_head_added };
+	if (eating){
+		board->score++;
+		board->changes[changes++] = (struct gake_delta){ next, gake_apple_eaten };
+		spawn_apple(board);
+		if (board->apple == UINT32_MAX) /* The board is full, so the game has been won. */
+			board->alive = 0;
+		else
+			board->changes[changes++] = (struct gake_delta){ board->apple, gake_apple_spawned };
+	}
+	board->change_count = changes;
+	return board->alive;
+}
+
+/* Fills in everything in `state` except the keys.  The occupancy grid (or the chunks) and body are handed over as-is, so the program sees exactly what the board does, and so are the changes from the last step if `deltas` is set. */
+void board_describe(const struct board * board, struct gake_curstate * state, bool deltas)
+{
+	uint32_t head = board->body[board->head];
+	state->version = GAKE_ABI_VERSION;
+	state->size = sizeof *state;
+	state->frame = board->frames;
+	state->width = board->width;
+	state->height = board->height;
+	state->head_x = head % board->width;
+	state->head_y = head / board->width;
+	state->apple_x = board->apple == UINT32_MAX ? -1 : (int)(board->apple % board->width);
+	state->apple_y = board->apple == UINT32_MAX ? -1 : (int)(board->apple / board->width);
+	state->length = board->length;
+	state->direction = board->direction;
+	state->alive = board->alive;
+	state->occupancy = board->occupancy;
+	state->body = board->body;
+	state->body_mask = board->mask;
+	state->body_head = board->head;
+	state->deltas = deltas ? board->changes : NULL;
+	state->delta_count = deltas ? board->change_count : 0;
+	state->chunks = (const uint64_t * const *)board->chunks;
+	state->chunk_columns = board->chunk_columns;
+	state->topology = board->topology;
+}
+
+static size_t grid_bytes(const struct board * board)
+{
+	if (board->occupancy == NULL)
+		return board->chunk_count * sizeof (struct board_image_chunk);
+	return ((uint32_t)board->width * board->height + 63) / 64 * sizeof (uint64_t);
+}
+
+size_t board_image_size(const struct board * board)
+{
+	return sizeof (struct board_image) + grid_bytes(board) + board->length * sizeof (uint32_t);
+}
+
+/* `image` needs `board_image_size()` bytes of room.  It doesn't need to be aligned. */
+void board_save(const struct board * board, void * image)
+{
+	struct board_image header = {
+		.width = board->width,
+		.height = board->height,
+		.mask = board->mask,
+		.head = board->head,
+		.length = board->length,
+		.apple = board->apple,
+		.direction = board->direction,
+		.score = board->score,
+		.rng = board->rng,
+		.frames = board->frames,
+		.alive = board->alive,
+		.topology = board->topology,
+		.chunks = board->occupancy == NULL ? board->chunk_count : 0
+	};
+	char * at = image;
+	memcpy(at, &header, sizeof header);
+	at += sizeof header;
+	if (board->occupancy != NULL){
+		memcpy(at, board->occupancy, grid_bytes(board));
+		at += grid_bytes(board);
+	} else {
+		for (register uint32_t i = 0; i < board->chunk_count; i++){
+			struct board_image_chunk chunk = { .index = board->chunk_list[i] };
+			memcpy(chunk.rows, board->chunks[chunk.index], sizeof chunk.rows);
+			memcpy(at, &chunk, sizeof chunk);
+			at += sizeof chunk;
+		}
+	}
+	/* The body is at most two runs of the ring:  from the tail to the end, then from the start to the head. */
+	uint32_t tail = (board->head - board->length + 1) & board->mask;
+	uint32_t first = board->mask + 1 - tail < board->length ? board->mask + 1 - tail : board->length;
+	memcpy(at, &board->body[tail], first * sizeof (uint32_t));
+	memcpy(at + first * sizeof (uint32_t), board->body, (board->length - first) * sizeof (uint32_t));
+}
+
+/* Makes sure that `board` has room for a board this size with a ring of `slots`, keeping what it has if it's already the right size, and clears it (which for a chunked board means getting rid of its chunks).  (A flat grid doesn't get cleared, since whatever calls this always copies a whole one in.)  Leaves `board` alone if it can't. */
+static bool resize(struct board * board, int width, int height, uint32_t slots)
+{
+	uint32_t cells = (uint32_t)width * height;
+	bool chunked = cells > BOARD_FLAT_CELLS;
+	if (board->body == NULL || board->width != width || board->height != height){
+		uint64_t * occupancy = chunked ? NULL : malloc((cells + 63) / 64 * sizeof (uint64_t));
+		uint64_t ** chunks = chunked ? calloc((size_t)chunk_columns(width) * chunk_rows(height), sizeof (uint64_t *)) : NULL;
+		uint32_t * body = malloc(slots * sizeof (uint32_t));
+		if ((occupancy == NULL && chunks == NULL) || body == NULL){
+			free(occupancy);
+			free(chunks);
+			free(body);
+			return 0;
+		}
+		board_free(board);
+		board->occupancy = occupancy;
+		board->chunks = chunks;
+		board->chunk_columns = chunked ? chunk_columns(width) : 0;
+		board->body = body;
+	} else {
+		if (board->mask + 1 != slots){
+			uint32_t * body = malloc(slots * sizeof (uint32_t));
+			if (body == NULL)
+				return 0;
+			free(board->body);
+			board->body = body;
+		}
+		for (register uint32_t i = 0; i < board->chunk_count; i++){
+			free(board->chunks[board->chunk_list[i]]);
+			board->chunks[board->chunk_list[i]] = NULL;
+		}
+		board->chunk_count = 0;
+	}
+	board->mask = slots - 1;
+	board->width = width;
+	board->height = height;
+	return 1;
+}
+
+/* Whether a board this size could have a ring of `slots`.  A flat board's is always the same size; a chunked board's has to be a power of two that the snake fits in. */
+static bool slots_ok(int width, int height, uint32_t slots, uint32_t length)
+{
+	uint32_t cells = (uint32_t)width * height;
+	if (cells <= BOARD_FLAT_CELLS)
+		return slots == flat_slots(cells);
+	return slots != 0 && (slots & (slots - 1)) == 0 && slots >= length && slots <= (uint32_t)1 << 31;
+}
+
+/* Reuses the memory that `board` already has if it's the right size, so a board that's loaded over and over doesn't keep going back to `malloc()`.  `board` has to be either set up or zeroed.  `size` is how much room there is, so anything past the end of the image is ignored.  Returns 0, leaving `board` alone, if `image` doesn't make sense; if it runs out of memory partway through the chunks of a chunked board, or finds the same chunk twice, it returns 0 and `board` is left freed. */
+bool board_load(struct board * board, const void * image, size_t size)
+{
+	struct board_image header;
+	if (size < sizeof header)
+		return 0;
+	memcpy(&header, image, sizeof header);
+	if (!board_size_ok(header.width, header.height))
+		return 0;
+	uint32_t cells = (uint32_t)header.width * header.height;
+	bool chunked = cells > BOARD_FLAT_CELLS;
+	uint32_t total_chunks = chunk_columns(header.width) * chunk_rows(header.height);
+	if ((chunked && header.chunks > total_chunks) || (!chunked && header.chunks != 0))
+		return 0;
+	size_t grid = chunked ? header.chunks * sizeof (struct board_image_chunk) : (cells + 63) / 64 * sizeof (uint64_t);
+	if (header.mask == UINT32_MAX || header.length == 0 || header.length > cells || !slots_ok(header.width, header.height, header.mask + 1, header.length) || size < sizeof header + grid + header.length * sizeof (uint32_t))
+		return 0;
+	if ((header.apple >= cells && header.apple != UINT32_MAX) || header.direction < gake_up || header.direction > gake_right || !board_topology_ok(header.topology, header.width, header.height))
+		return 0;
+	const char * grid_at = (const char *)image + sizeof header;
+	for (register uint32_t i = 0; chunked && i < header.chunks; i++){
+		uint32_t index;
+		memcpy(&index, grid_at + i * sizeof (struct board_image_chunk) + offsetof(struct board_image_chunk, index), sizeof index);
+		if (index >= total_chunks)
+			return 0;
+	}
+	const char * body_at = grid_at + grid;
+	for (register uint32_t i = 0; i < header.length; i++){
+		uint32_t cell;
+		memcpy(&cell, body_at + i * sizeof cell, sizeof cell);
+		if (cell >= cells)
+			return 0;
+	}
+
+	if (!resize(board, header.width, header.height, header.mask + 1))
+		return 0;
+	board->head = header.head & header.mask;
+	board->length = header.length;
+	board->apple = header.apple;
+	board->direction = header.direction;
+	board->moved = header.direction;
+	board->score = header.score;
+	board->rng = header.rng;
+	board->frames = header.frames;
+	board->alive = header.alive;
+	board->change_count = 0;
+	set_topology(board, header.topology);
+	if (!chunked)
+		memcpy(board->occupancy, grid_at, grid);
+	/* Anything outside the board is ignored, and so is a chunk with nothing in it, since it wouldn't be there on a board that was played to this point. */
+	for (register uint32_t i = 0; chunked && i < header.chunks; i++){
+		struct board_image_chunk image_chunk;
+		memcpy(&image_chunk, grid_at + i * sizeof image_chunk, sizeof image_chunk);
+		uint32_t left = image_chunk.index % board->chunk_columns * BOARD_CHUNK_SIDE;
+		uint32_t top = image_chunk.index / board->chunk_columns * BOARD_CHUNK_SIDE;
+		uint64_t inside = board->width - left < BOARD_CHUNK_SIDE ? ((uint64_t)1 << (board->width - left)) - 1 : ~(uint64_t)0;
+		uint32_t count = 0;
+		for (register uint32_t row = 0; row < BOARD_CHUNK_SIDE; row++){
+			image_chunk.rows[row] = top + row < (uint32_t)board->height ? image_chunk.rows[row] & inside : 0;
+			count += __builtin_popcountll(image_chunk.rows[row]);
+		}
+		if (count == 0)
+			continue;
+		uint64_t * chunk = board->chunks[image_chunk.index] == NULL ? make_chunk(board, image_chunk.index) : NULL; /* The same chunk twice doesn't make sense either. */
+		if (chunk == NULL){
+			board_free(board);
+			return 0;
+		}
+		memcpy(chunk, image_chunk.rows, sizeof image_chunk.rows);
+		chunk[BOARD_CHUNK_SIDE] |= count;
+	}
+	uint32_t tail = (board->head - board->length + 1) & board->mask;
+	uint32_t first = board->mask + 1 - tail < board->length ? board->mask + 1 - tail : board->length;
+	memcpy(&board->body[tail], body_at, first * sizeof (uint32_t));
+	memcpy(board->body, body_at + first * sizeof (uint32_t), (board->length - first) * sizeof (uint32_t));
+	board->epoch++;
+	return 1;
+}
+
+/* The opposite of `board_describe()`, for making a board out of what a program was told.  The state doesn't say where the next apples will be or what the score is, so those come from `seed` and 0. */
+bool board_adopt(struct board * board, const struct gake_curstate * state, uint64_t seed)
+{
+	if (!board_size_ok(state->width, state->height))
+		return 0;
+	uint32_t cells = (uint32_t)state->width * state->height;
+	bool chunked = cells > BOARD_FLAT_CELLS;
+	if (state->body_mask == UINT32_MAX || state->length == 0 || state->length > cells || !slots_ok(state->width, state->height, state->body_mask + 1, state->length) || state->direction < gake_up || state->direction > gake_right)
+		return 0;
+	if (chunked ? state->size < offsetof(struct gake_curstate, chunk_columns) + sizeof state->chunk_columns || state->chunks == NULL : state->occupancy == NULL)
+		return 0;
+	enum gake_topology topology = state->size >= offsetof(struct gake_curstate, topology) + sizeof state->topology ? state->topology : gake_plane;
+	if (!board_topology_ok(topology, state->width, state->height))
+		return 0;
+	/* Each coordinate is checked on its own, since one that's off the end of its row or column could still come out as some other cell. */
+	if (state->apple_x >= 0 && (state->apple_x >= state->width || state->apple_y < 0 || state->apple_y >= state->height))
+		return 0;
+	uint32_t apple = state->apple_x < 0 ? UINT32_MAX : (uint32_t)state->apple_y * state->width + state->apple_x;
+	/* Only the part of the ring that the snake is in gets copied; in an isolated program, that's all that's filled in. */
+	uint32_t tail = (state->body_head - state->length + 1) & state->body_mask;
+	uint32_t first = state->body_mask + 1 - tail < state->length ? state->body_mask + 1 - tail : state->length;
+	for (register uint32_t i = 0; i < state->length; i++){
+		if (state->body[(tail + i) & state->body_mask] >= cells)
+			return 0;
+	}
+	if (!resize(board, state->width, state->height, state->body_mask + 1))
+		return 0;
+	board->head = state->body_head & state->body_mask;
+	board->length = state->length;
+	board->apple = apple;
+	board->direction = state->direction;
+	board->moved = state->direction;
+	board->score = 0;
+	board->rng = seed;
+	board->frames = state->frame;
+	board->alive = state->alive;
+	board->change_count = 0;
+	set_topology(board, topology);
+	memcpy(&board->body[tail], &state->body[tail], first * sizeof (uint32_t));
+	memcpy(board->body, state->body, (state->length - first) * sizeof (uint32_t));
+	if (!chunked){
+		memcpy(board->occupancy, state->occupancy, (cells + 63) / 64 * sizeof (uint64_t));
+	} else {
+		/* The snake is exactly what's occupied, so going over it is the same as copying the chunks, without having to look through the directory for them. */
+		for (register uint32_t i = 0; i < board->length; i++){
+			if (!occupy(board, board_segment(board, i))){
+				board_free(board);
+				return 0;
+			}
+		}
+	}
+	board->epoch++;
+	return 1;
+}
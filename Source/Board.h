@@ -0,0 +1,204 @@
+/* LICENSE
+ *
+ * Copyright © 2021 Blue-Maned_Hawk.  All rights reserved.
+ *
+ * This software should have come with a file called LICENSE.  In case of any difference between this comment and that file, that file is the authority.  (If you did not recieve that file, it's a violation of the license.  Please report it to me.)
+ *
+ * This project is copylefted.  You may freely use, distribute, and modify this software, to the extent permitted by law, so long as you do not attempt to claim such activities are condoned by the author, you distribute the license file with any distributions of this software, you release any modifications under a similar license, and you do not attempt to claim that modified software is the original software.
+ *
+ * This license does not apply to software created with the API of this software (thought it does apply to the API itself); it also does not apply to any rule files, all of which must be placed in the public domain.
+ *
+ * This software links to zlib, which is under the zlib license, available at https://www.zlib.net/zlib_license.html.
+ *
+ * This software dynamically links to SDL2, which is under a separate instance of the zlib license, available at https://libsdl.org/license.php.
+ *
+ * This software dynamically links to libgcrypt, which is under the GNU LGPL2.1+, available at https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=COPYING;h=ccbbaf61b794c7aaea10dffb486095fdc8f3a44a;hb=HEAD.
+ *
+ * This license does not apply to trademarks or patents.
+ *
+ * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
+
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../gake.h"
+
+/* Boards can be up to this many cells across and down, which keeps every cell's number in 32 bits with `UINT32_MAX` left over to mean "no apple". */
+#define BOARD_MAX_SIDE 65535
+
+/* Boards with more cells than this (a bit more than 2048 by 2048) are chunked; see `struct board`. */
+#define BOARD_FLAT_CELLS ((uint32_t)1 << 22)
+
+/* A chunk is 64 by 64 cells, with one word for each row. */
+#define BOARD_CHUNK_SIDE 64
+
+/* Boards with at most this many cells step through a neighbour table instead of working out where the head goes; see `neighbour_table()` in `Source/Board.c`. */
+#define BOARD_TABLE_CELLS ((uint32_t)1 << 16)
+
+/* Every topology, with the letter that Golly uses for it.  Everything that has to be done differently for each one is written once as a macro and stamped out for each of these, so that the code that moves the snake never has to check which one it's on. */
+#define BOARD_TOPOLOGIES(X)\
+	X(plane, 'P')\
+	X(torus, 'T')\
+	X(klein_bottle, 'K')\
+	X(cross_surface, 'C')\
+	X(sphere, 'S')
+
+struct board;
+typedef bool board_stepper(struct board * board, enum gake_direction direction);
+
+/* The occupancy grid is one bit per cell, row by row, packed into 64-bit words, so checking a cell is a shift and a mask.  The body is a ring buffer whose size is a power of two, so moving is one write at the head and one bit cleared at the tail, and wrapping around is just `& mask`.
+ *
+ * That's fine up to a few million cells, but a flat grid of the biggest board would be half a gigabyte, and a ring big enough for a snake that fills it would be sixteen.  So boards bigger than `BOARD_FLAT_CELLS` are chunked instead:  `occupancy` is NULL, and `chunks` has a pointer for each 64 by 64 square of cells, which is NULL unless the snake is in it; and the ring starts small and doubles whenever the snake outgrows it.  That keeps the memory a board uses in proportion to the snake, not to the board.  (The directory of chunks is eight bytes for each 4096 cells, but it comes from `calloc()`, so the parts of it that are never written to never take up any memory either.) */
+struct board {
+	int width;
+	int height;
+	uint64_t * occupancy; /* NULL if the board is chunked. */
+	uint64_t ** chunks; /* NULL if the board is flat. */
+	uint32_t * chunk_list; /* Which chunks there are, so they can be gone through without looking through the whole directory. */
+	uint32_t chunk_columns;
+	uint32_t chunk_count; /* How many there are in `chunk_list`. */
+	uint32_t chunk_room;
+	uint32_t * body; /* Cell indices of the snake; `body[head]` is the head, and the tail is `length - 1` before it. */
+	uint32_t mask; /* The size of `body`, minus one. */
+	uint32_t head; /* Index into `body`, not a cell index. */
+	uint32_t length;
+	uint32_t apple;
+	enum gake_direction direction;
+	enum gake_direction moved; /* Which way the head went on the last step, before the edge of the board turned it (which only a sphere does).  Stepping in this again always does the same thing, which isn't true of `direction`, so it's what replays record. */
+	uint64_t rng;
+	long long frames;
+	unsigned score;
+	bool alive;
+	uint32_t change_count;
+	enum gake_topology topology;
+	board_stepper * step; /* The version of `board_step()` for `topology`, or the one that uses `neighbours`. */
+	const uint32_t * neighbours; /* For small boards; see `neighbour_table()` in `Source/Board.c`.  Shared between every board of the same size and topology, and never freed. */
+	struct gake_delta changes[4]; /* What the last step did to the board, for programs that want to keep track of it themselves. */
+	uint64_t epoch; /* Changes whenever the board is set up or loaded instead of stepped, or the body is moved to a bigger ring, so that anything keeping its own picture of the board (like `Source/Sprites.c`) knows to start that over. */
+};
+
+/* A board packed into one flat blob, for keyframes:  this, then the occupancy grid (or, for a chunked board, each chunk that it has), then the body from the tail to the head.  The changes from the last step aren't kept. */
+struct board_image {
+	int32_t width;
+	int32_t height;
+	uint32_t mask;
+	uint32_t head;
+	uint32_t length;
+	uint32_t apple;
+	uint32_t direction;
+	uint32_t score;
+	uint64_t rng;
+	int64_t frames;
+	uint8_t alive;
+	uint8_t topology;
+	uint8_t padding[2];
+	uint32_t chunks; /* How many `struct board_image_chunk` come before the body, instead of the occupancy grid, if the board is chunked. */
+};
+
+struct board_image_chunk {
+	uint32_t index; /* Into `struct board`'s `chunks`. */
+	uint32_t padding;
+	uint64_t rows[BOARD_CHUNK_SIDE];
+};
+
+static inline bool board_size_ok(int64_t width, int64_t height)
+{
+	return width >= 3 && height >= 3 && width <= BOARD_MAX_SIDE && height <= BOARD_MAX_SIDE;
+}
+
+/* A sphere's top and left edges are joined, so they have to be the same length. */
+static inline bool board_topology_ok(uint32_t topology, int64_t width, int64_t height)
+{
+	return topology <= gake_sphere && (topology != gake_sphere || width == height);
+}
+
+static inline bool board_occupied(const struct board * board, uint32_t cell)
+{
+	if (board->occupancy != NULL)
+		return (board->occupancy[cell >> 6] >> (cell & 63)) & 1;
+	uint32_t x = cell % board->width;
+	uint32_t y = cell / board->width;
+	const uint64_t * chunk = board->chunks[(y / BOARD_CHUNK_SIDE) * board->chunk_columns + x / BOARD_CHUNK_SIDE];
+	return chunk != NULL && (chunk[y % BOARD_CHUNK_SIDE] >> (x % BOARD_CHUNK_SIDE)) & 1;
+}
+
+static inline uint32_t board_segment(const struct board * board, uint32_t from_tail)
+{
+	return board->body[(board->head - board->length + 1 + from_tail) & board->mask];
+}
+
+/* Which way the snake actually goes when it's going `current` and `wanted` is asked for.  Going back on itself is treated as going straight, the same as in Google Snake.  This is written without branches so that the batch kernel in `Source/Batch.c` can vectorize it. */
+static inline int board_turn(int current, int wanted)
+{
+	bool turns = wanted != gake_ahead && ((wanted >= gake_left) != (current >= gake_left));
+	return turns ? wanted : current;
+}
+
+static inline int board_dx(int direction)
+{
+	return (direction == gake_right) - (direction == gake_left);
+}
+
+static inline int board_dy(int direction)
+{
+	return (direction == gake_down) - (direction == gake_up);
+}
+
+/* These take where the head would go if there were no edges, and bring it back onto the board the way the topology says to (turning it, on a sphere), returning whether it ran into a wall instead.  The head only ever moves one cell along one axis, so at most one edge is ever crossed.  Like `board_turn()`, they're written so that the batch kernel can vectorize them. */
+static inline bool board_wrap_plane(int32_t * x, int32_t * y, int32_t * direction [[maybe_unused]], int32_t width, int32_t height)
+{
+	return (*x < 0) | (*y < 0) | (*x >= width) | (*y >= height);
+}
+
+static inline bool board_wrap_torus(int32_t * x, int32_t * y, int32_t * direction [[maybe_unused]], int32_t width, int32_t height)
+{
+	*x = *x < 0 ? width - 1 : *x >= width ? 0 : *x;
+	*y = *y < 0 ? height - 1 : *y >= height ? 0 : *y;
+	return 0;
+}
+
+static inline bool board_wrap_klein_bottle(int32_t * x, int32_t * y, int32_t * direction, int32_t width, int32_t height)
+{
+	bool across = (*x < 0) | (*x >= width);
+	board_wrap_torus(x, y, direction, width, height);
+	*y = across ? height - 1 - *y : *y;
+	return 0;
+}
+
+static inline bool board_wrap_cross_surface(int32_t * x, int32_t * y, int32_t * direction, int32_t width, int32_t height)
+{
+	bool across = (*x < 0) | (*x >= width);
+	bool down = (*y < 0) | (*y >= height);
+	board_wrap_torus(x, y, direction, width, height);
+	*y = across ? height - 1 - *y : *y;
+	*x = down ? width - 1 - *x : *x;
+	return 0;
+}
+
+/* `width` and `height` are the same. */
+static inline bool board_wrap_sphere(int32_t * x, int32_t * y, int32_t * direction, int32_t width, int32_t height)
+{
+	bool top = *y < 0, left = *x < 0, bottom = *y >= height, right = *x >= width;
+	int32_t old_x = *x, old_y = *y;
+	*x = top ? 0 : left ? old_y : bottom ? width - 1 : right ? old_y : old_x;
+	*y = top ? old_x : left ? 0 : bottom ? old_x : right ? height - 1 : old_y;
+	*direction = top ? gake_right : left ? gake_down : bottom ? gake_left : right ? gake_up : *direction;
+	return 0;
+}
+
+extern bool board_init(struct board * board, int width, int height, enum gake_topology topology, uint64_t seed);
+extern void board_free(struct board * board);
+extern bool board_step(struct board * board, enum gake_direction direction);
+extern bool board_move(struct board * board, uint32_t next, bool blocked);
+extern void board_describe(const struct board * board, struct gake_curstate * state, bool deltas);
+extern size_t board_image_size(const struct board * board);
+extern void board_save(const struct board * board, void * image);
+extern bool board_load(struct board * board, const void * image, size_t size);
+extern bool board_adopt(struct board * board, const struct gake_curstate * state, uint64_t seed);
+extern const char * board_topology_name(enum gake_topology topology);
+extern bool board_topology_named(const char * name, enum gake_topology * topology);
+
+#endif/*ndef BOARD_H*/
@@ -19,11 +19,14 @@
  * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
 
 /* This file contains a subroutine run at program startup to verify the assets and check the battery level.
+ *
+ * Hashing the assets costs more than everything else at startup put together (most of it in getting libgcrypt going), and it's the same answer every time unless they change, so an asset that passed is remembered in a cache, along with which file it was and when it was last changed.  After that, it's only hashed again if it's been touched.  The cache can only ever skip the hashing of an asset that did pass, so deleting it is always safe.
  *
  * When reading this file, you are expected to have access to and generally understand the following documents:
  * 	· Latest draft of C2x:  http://www.open-std.org/JTC1/SC22/WG14/www/docs/n2596.pdf
  * 	· The Clang compiler user(?) manual:  https://clang.llvm.org/docs/UsersManual.html
- * 	· The latest POSIX specification:  https://pubs.opengroup.org/onlinepubs/9699919799/mindex.html */
+ * 	· The latest POSIX specification:  https://pubs.opengroup.org/onlinepubs/9699919799/mindex.html
+ * 	· The libgcrypt manual:  https://gnupg.org/documentation/manuals/gcrypt/ */
 
 
 #define _POSIX_C_SOURCE 200809L
@@ -38,82 +41,202 @@
 #include <gcrypt.h> /* TODO: I'm not happy about the usage of GNU stuff, especially a package as bloated as this one. */
 #include <string.h>
 #include <stdbool.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
 
 static const struct file_data files_list[2] = {
 	{{0xa6887d3b0009db06, 0xbe6109d1a7cce845, 0xca51ed831fc11d3e, 0x5434aa67c5a9f631, 0x0ae486d254678172, 0x654aa504a784e36e, 0x60c5035f012d5dee, 0x309ca07bf221c709}, 520, "/usr/local/share/Gake/Assets/Textures.png"},
 	{{0xfec0992f7258d68b, 0x462cde2e71bdb86a, 0x27d04471a1e8161d, 0xb949f827864be05e, 0xd6a1eb880efd90dd, 0xfe3f6cc7e4cc81a9, 0x063439e66eb90df5, 0x9f9bad72827c531f}, 2761, "/usr/local/share/Gake/Assets/Log_Splashes.txt"}
 };
 
-short run_checks(void)
+#define FILES_COUNT ((sizeof files_list) / (sizeof (struct file_data)))
+
+/* What the cache remembers about an asset that passed.  `checksum` is the one it was checked against, so that a new version of Gake with new assets doesn't trust an old cache. */
+struct check_record {
+	uint64_t device;
+	uint64_t inode;
+	int64_t size;
+	int64_t mtime_sec;
+	int64_t mtime_nsec;
+	long long checksum[8];
+};
+
+struct check_cache {
+	char magic[8]; /* "GAKECHK" */
+	uint32_t version;
+	uint32_t count;
+	struct check_record records[FILES_COUNT];
+};
+
+static void cache_filename(char * filename, size_t size)
+{
+	char * cache = getenv("XDG_CACHE_HOME");
+	char * home = getenv("HOME");
+	char directory[256];
+	if (cache != NULL && cache[0] != '\0')
+		snprintf(directory, sizeof directory, "%s", cache);
+	else if (home != NULL)
+		snprintf(directory, sizeof directory, "%s/.cache", home);
+	else {
+		filename[0] = '\0';
+		return;
+	}
+	mkdir(directory, 0755);
+	snprintf(filename, size, "%s/Gake", directory);
+	mkdir(filename, 0755);
+	snprintf(filename, size, "%s/Gake/Asset_Checks.bin", directory);
+}
+
+static struct check_record record_of(const struct stat * info, const long long checksum[8])
+{
+	struct check_record record = {
+		.device = info->st_dev,
+		.inode = info->st_ino,
+		.size = info->st_size,
+		.mtime_sec = info->st_mtim.tv_sec,
+		.mtime_nsec = info->st_mtim.tv_nsec
+	};
+	memcpy(record.checksum, checksum, sizeof record.checksum);
+	return record;
+}
+
+/* Only done the first time something actually needs hashing, since it's not cheap. */
+static void start_gcrypt(void)
+{
+	static bool started = 0;
+	if (started)
+		return;
+	gcry_check_version(NULL);
+	gcry_control(GCRYCTL_INITIALIZATION_FINISHED, 0);
+	started = 1;
+}
+
+/* Reads and hashes one asset, the slow way. */
+static bool verify(const struct file_data * data)
 {
-	logmsg(lp_debug, lc_checks, "Verifying assets…");
 	uint8_t buf[0xFFF] = {};
-	FILE * file;
 	long long checksum[8];
 	size_t size;
+	FILE * file = fopen(data->filename, "rb");
+	if (file == NULL){
+		logmsg(lp_err, lc_checks, "File %s does not exist.", data->filename);
+		return 0;
+	}
+	size = fread(buf, sizeof (uint8_t), (sizeof buf) / (sizeof (uint8_t)), file);
+	fclose(file);
+	if (size != data->size){
+		logmsg(lp_err, lc_checks, "Expected file %s to have size %zd, but got size %zd.", data->filename, data->size, size);
+		return 0;
+	}
+	start_gcrypt();
+	gcry_md_hash_buffer(GCRY_MD_SHA3_512, &checksum, &buf, sizeof buf);
+	if (memcmp(checksum, data->checksum, sizeof checksum)){
+		char realsum_str[129] = "";
+		char badsum_str[129] = "";
+		char sect[17];
+		for (register size_t j = 0; j < ((sizeof checksum) / sizeof (long long)); j++){
+			sprintf(sect, "%.16llx", checksum[j]);
+			strcat(badsum_str, sect);
+		}
+		for (register size_t j = 0; j < ((sizeof data->checksum) / sizeof (long long)); j++){
+			sprintf(sect, "%.16llx", data->checksum[j]);
+			strcat(realsum_str, sect);
+		}
+		logmsg(lp_err, lc_checks, "Expected file %s to have checksum %s, but got checksum %s.", data->filename, realsum_str, badsum_str);
+		return 0;
+	}
+	return 1;
+}
+
+/* Picks one line of the file at random, in one pass:  the `n`th line replaces the one picked so far with a chance of 1 in `n`, which leaves every line equally likely. */
+static char * pick_splash(FILE * splashfile)
+{
+	uint64_t rng;
+	FILE * random = fopen("/dev/urandom", "rb");
+	if (random == NULL || fread(&rng, sizeof rng, 1, random) != 1)
+		rng = (uintptr_t)&rng ^ (uint64_t)time(NULL);
+	if (random != NULL)
+		fclose(random);
+
+	char * line = NULL, * picked = NULL;
+	size_t len = 0, picked_len = 0;
+	ssize_t got;
+	for (uint64_t n = 1; (got = getline(&line, &len, splashfile)) > 0; n++){
+		/* This is splitmix64 again; see `Source/Board.c`. */
+		uint64_t z = (rng += 0x9e3779b97f4a7c15);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+		if ((z ^ (z >> 31)) % n != 0)
+			continue;
+		char * swap = picked;
+		size_t swap_len = picked_len;
+		picked = line;
+		picked_len = len;
+		line = swap;
+		len = swap_len;
+	}
+	free(line);
+	return picked;
+}
+
+short run_checks(bool headless)
+{
+	logmsg(lp_debug, lc_checks, "Verifying assets…");
 	bool errors = 0;
-	for (register unsigned i = 0; i < ((sizeof files_list) / (sizeof (struct file_data))); i++){
+	char filename[512];
+	cache_filename(filename, sizeof filename);
+	struct check_cache cache = {};
+	FILE * cachefile = filename[0] != '\0' ? fopen(filename, "rb") : NULL;
+	if (cachefile != NULL){
+		if (fread(&cache, sizeof cache, 1, cachefile) != 1 || memcmp(cache.magic, "GAKECHK", 8) != 0 || cache.version != 1 || cache.count != FILES_COUNT)
+			cache = (struct check_cache){};
+		fclose(cachefile);
+	}
+	struct check_cache passed = { .magic = "GAKECHK", .version = 1, .count = FILES_COUNT };
+	unsigned hashed = 0;
+	for (register unsigned i = 0; i < FILES_COUNT; i++){
 		logmsg(lp_debug, lc_checks, "Testing asset %s…", files_list[i].filename);
-		if ((file = fopen(files_list[i].filename, "rb")) == NULL){
+		struct stat info;
+		if (stat(files_list[i].filename, &info) != 0){
 			logmsg(lp_err, lc_checks, "File %s does not exist.", files_list[i].filename);
 			errors = 1;
-		} else if ((size = fread(buf, sizeof (uint8_t), (sizeof buf) / (sizeof (uint8_t)), file)) != files_list[i].size){
-			logmsg(lp_err, lc_checks, "Expected file %s to have size %zd, but got size %zd.", files_list[i].filename, files_list[i].size, size);
+			continue;
+		}
+		passed.records[i] = record_of(&info, files_list[i].checksum);
+		if (memcmp(&passed.records[i], &cache.records[i], sizeof (struct check_record)) == 0)
+			continue; /* Nothing about it has changed since it last passed. */
+		hashed++;
+		if (!verify(&files_list[i])){
 			errors = 1;
-		} else {
-			gcry_md_hash_buffer(GCRY_MD_SHA3_512, &checksum, &buf, sizeof buf);
-			if (memcmp(checksum, files_list[i].checksum, sizeof checksum)){
-				char realsum_str[129] = "";
-				char badsum_str[129] = "";
-				char sect[17];
-				for (register size_t j = 0; j < ((sizeof checksum) / sizeof (long long)); j++){
-					sprintf(sect, "%.16llx", checksum[j]);
-					strcat(badsum_str, sect);
-				}
-				for (register size_t j = 0; j < ((sizeof files_list[i].checksum) / sizeof (long long)); j++){
-					sprintf(sect, "%.16llx", files_list[i].checksum[j]);
-					strcat(realsum_str, sect);
-				}
-				logmsg(lp_err, lc_checks, "Expected file %s to have checksum %s, but got checksum %s.", files_list[i].filename, realsum_str, badsum_str);
-				errors = 1;
-			}
+			passed.records[i] = (struct check_record){};
+		}
+	}
+	if (hashed > 0 && filename[0] != '\0'){
+		/* Written somewhere else and then moved into place, so that two copies of Gake starting at once can't leave half of a cache behind. */
+		char temporary[sizeof filename + 16];
+		snprintf(temporary, sizeof temporary, "%s.%ld", filename, (long)getpid());
+		if ((cachefile = fopen(temporary, "wb")) != NULL){
+			bool written = fwrite(&passed, sizeof passed, 1, cachefile) == 1;
+			if (fclose(cachefile) == 0 && written)
+				rename(temporary, filename);
+			else
+				remove(temporary);
 		}
-		fclose(file);
-		memset(buf, 0, sizeof buf);
 	}
 	if (errors){
 		logmsg(lp_err, lc_checks, "Assets could not be verified.  Crashing now…");
 		return 1;
 	}
-	logmsg(lp_info, lc_checks, "All assets have been verified!");
+	logmsg(lp_info, lc_checks, "All assets have been verified!  (%u of %zu had to be hashed; the rest hadn't changed since they last were.)", hashed, FILES_COUNT);
 
-	char * logsplash = NULL;
-	int nlcount = 0;
-	int character = 0;
 	FILE * splashfile = fopen("/usr/local/share/Gake/Assets/Log_Splashes.txt", "r");
-	if (splashfile == NULL){
-fail:
+	char * logsplash = splashfile != NULL ? pick_splash(splashfile) : NULL;
+	if (splashfile != NULL)
+		fclose(splashfile);
+	if (logsplash == NULL){
 		logmsg(lp_info, lc_checks, "\e[38;2;255;255;128mFailing to find a log splash…\e[m");
 	} else {
-		size_t len = 0;
-		fseek(splashfile, 0, SEEK_SET);
-		for (register int i = 0; (character = fgetc(splashfile)) != EOF; i++)
-			(character == '\n') ? nlcount++ : ((void)0);
-
-		FILE * random = fopen("/dev/urandom", "rb");
-		long long randnum[1];
-		fread(randnum, sizeof (long long), (sizeof randnum) / sizeof (long long), random);
-		fclose(random);
-		int line = llabs(randnum[0] % nlcount);
-
-		fseek(splashfile, 0, SEEK_SET);
-		for (register int i = 0; i < line; i++){
-			getline(&logsplash, &len, splashfile);
-		}
-
-		if (logsplash == NULL)
-			goto fail;
-
 		char * nl;
 		if ((nl = strchr(logsplash, '\n')) != NULL)
 			*nl = ' ';
@@ -121,7 +244,9 @@ fail:
 		logmsg(lp_info, lc_checks, "\e[38;2;255;255;128m%s\e[m", logsplash);
 	}
 	free(logsplash);
-	fclose(splashfile);
+
+	if (headless)
+		return 0;
 
 	int secs, pct;
 	SDL_PowerState power = SDL_GetPowerInfo(&secs, &pct);
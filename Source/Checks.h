@@ -21,12 +21,16 @@
 #ifndef CHECKS_H
 #define CHECKS_H
 
+#include <stdbool.h>
+#include <stddef.h>
+
 struct file_data {
 	long long checksum[8];
 	size_t size;
 	char filename[256];
 };
 
-extern short run_checks(void);
+/* When `headless` is set, the battery isn't checked, since that can pop up a window. */
+extern short run_checks(bool headless);
 
 #endif
@@ -38,6 +38,7 @@
 #include <sys/stat.h>
 #include <errno.h>
 #include <stdbool.h>
+#include "Logging.h"
 
 uint8_t crashno;
 char crashstr[512]; /* Should be enough for anything, right? */
@@ -195,6 +196,9 @@ void handler(int signo, siginfo_t * info, [[maybe_unused]] void * context)
 		break;
 	}
 
+	/* Whatever was logged before the crash is written out first, so that it comes before the crash in the terminal and makes it into the logfile. */
+	crash_logging();
+
 	char msg_box_msg[1024];
 	sprintf(msg_box_msg,
 			"A critical error has occured, and Gake has crashed!\n"
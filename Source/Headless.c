@@ -0,0 +1,145 @@
+/* LICENSE
+ *
+ * Copyright © 2021 Blue-Maned_Hawk.  All rights reserved.
+ *
+ * This software should have come with a file called LICENSE.  In case of any difference between this comment and that file, that file is the authority.  (If you did not recieve that file, it's a violation of the license.  Please report it to me.)
+ *
+ * This project is copylefted.  You may freely use, distribute, and modify this software, to the extent permitted by law, so long as you do not attempt to claim such activities are condoned by the author, you distribute the license file with any distributions of this software, you release any modifications under a similar license, and you do not attempt to claim that modified software is the original software.
+ *
+ * This license does not apply to software created with the API of this software (thought it does apply to the API itself); it also does not apply to any rule files, all of which must be placed in the public domain.
+ *
+ * This software links to zlib, which is under the zlib license, available at https://www.zlib.net/zlib_license.html.
+ *
+ * This software dynamically links to SDL2, which is under a separate instance of the zlib license, available at https://libsdl.org/license.php.
+ *
+ * This software dynamically links to libgcrypt, which is under the GNU LGPL2.1+, available at https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=COPYING;h=ccbbaf61b794c7aaea10dffb486095fdc8f3a44a;hb=HEAD.
+ *
+ * This license does not apply to trademarks or patents.
+ *
+ * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
+
+/* This file runs the game without SDL:  no window, no renderer, and no frame pacing.  Every loaded program gets its own batch of boards (see `Source/Batch.c`) and its own thread, and all of them are stepped as fast as the CPU allows until every snake is dead.
+ *
+ * When reading this file, you are expected to have access to and generally understand the following documents:
+ * 	· Latest draft of C2x:  http://www.open-std.org/JTC1/SC22/WG14/www/docs/n2596.pdf
+ * 	· The Clang compiler user(?) manual:  https://clang.llvm.org/docs/UsersManual.html
+ * 	· The latest POSIX specification:  https://pubs.opengroup.org/onlinepubs/9699919799/mindex.html */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "Headless.h"
+#include "Batch.h"
+#include "Board.h"
+#include "Logging.h"
+#include "Program.h"
+#include "Replay.h"
+#include "Trace.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+struct headless_run {
+	struct program * program;
+	struct batch batch;
+	struct gake_newstate * moves;
+	struct replay * replays; /* One per board, or NULL if nothing's being recorded. */
+	long long steps;
+	bool threaded;
+};
+
+/* The programs never have to wait for each other here, so each one just plays all of its games on its own thread. */
+static void * play(void * arg)
+{
+	struct headless_run * run = arg;
+	struct batch * batch = &run->batch;
+	struct program * program = run->program;
+	trace_enter(program->trace);
+	while (batch->living > 0){
+		batch_describe(batch, program->deltas);
+		/* Programs that can take the whole batch at once get it in one call. */
+		if (program->batch != NULL){
+			program->batch(batch->states, run->moves, batch->count);
+		} else {
+			for (register size_t j = 0; j < batch->count; j++){
+				if (batch->alive[j])
+					program_call(program, &batch->states[j], &run->moves[j]);
+			}
+		}
+		run->steps += batch->living;
+		batch_step(batch, run->moves);
+		/* The boards that moved are the ones whose frame count went up. */
+		for (register size_t j = 0; run->replays != NULL && j < batch->count; j++){
+			if ((uint64_t)batch->boards[j].frames != run->replays[j].header.frames)
+				replay_frame(&run->replays[j], &batch->boards[j]);
+		}
+	}
+	return NULL;
+}
+
+void run_headless(struct program * programs, short count, int width, int height, enum gake_topology topology, uint64_t seed, size_t games, struct replay_file * replays)
+{
+	struct headless_run runs[8] = {};
+	size_t total_games = 0;
+	long long steps = 0;
+
+	for (register short i = 0; i < count; i++){
+		runs[i].program = &programs[i];
+		/* Nothing ever ends the game of a program that just goes in circles, so a snake that goes four times the area of the board without eating dies. */
+		if (batch_init(&runs[i].batch, games, width, height, topology, seed, 4LL * width * height) && (runs[i].moves = calloc(games, sizeof (struct gake_newstate))) != NULL){
+			total_games += games;
+			if (replays != NULL && (runs[i].replays = calloc(games, sizeof (struct replay))) != NULL){
+				for (register size_t j = 0; j < games; j++)
+					replay_begin(replays, &runs[i].replays[j], &runs[i].batch.boards[j], seed + j, programs[i].name);
+			}
+		} else {
+			logmsg(lp_err, lc_api, "Could not make boards for program %s.", programs[i].name);
+			batch_free(&runs[i].batch);
+		}
+	}
+	logmsg(lp_info, lc_misc, "Running %zu headless game%s starting from seed %#llx…", total_games, total_games == 1 ? "" : "s", (unsigned long long)seed);
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (register short i = 0; i < count; i++){
+		if (runs[i].batch.boards == NULL)
+			continue;
+		runs[i].threaded = pthread_create(&programs[i].thread, NULL, play, &runs[i]) == 0;
+	}
+	/* If a thread couldn't be started, that program just gets played here once everything else is going. */
+	for (register short i = 0; i < count; i++){
+		if (runs[i].threaded)
+			pthread_join(programs[i].thread, NULL);
+		else if (runs[i].batch.boards != NULL)
+			play(&runs[i]);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	double secs = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	for (register short i = 0; i < count; i++){
+		struct batch * batch = &runs[i].batch;
+		if (batch->boards == NULL)
+			continue;
+		unsigned long long total = 0;
+		unsigned best = 0;
+		for (register size_t j = 0; j < batch->count; j++){
+			total += batch->boards[j].score;
+			if (batch->boards[j].score > best)
+				best = batch->boards[j].score;
+		}
+		if (batch->count == 1)
+			logmsg(lp_info, lc_apiprgm, "Program %s finished with a score of %u and a length of %u after %lld frames.", programs[i].name, batch->boards[0].score, batch->boards[0].length, batch->boards[0].frames);
+		else
+			logmsg(lp_info, lc_apiprgm, "Program %s finished %zu games with an average score of %.2f and a best score of %u.", programs[i].name, batch->count, (double)total / batch->count, best);
+		steps += runs[i].steps;
+		for (register size_t j = 0; runs[i].replays != NULL && j < batch->count; j++){
+			replay_write(&runs[i].replays[j], &batch->boards[j]);
+			replay_free(&runs[i].replays[j]);
+		}
+		free(runs[i].replays);
+		batch_free(batch);
+		free(runs[i].moves);
+	}
+	logmsg(lp_info, lc_misc, "Stepped %lld frames in %.3f seconds (%.0f frames per second).", steps, secs, secs > 0 ? steps / secs : 0.0);
+}
@@ -0,0 +1,293 @@
+/* LICENSE
+ *
+ * Copyright © 2021 Blue-Maned_Hawk.  All rights reserved.
+ *
+ * This software should have come with a file called LICENSE.  In case of any difference between this comment and that file, that file is the authority.  (If you did not recieve that file, it's a violation of the license.  Please report it to me.)
+ *
+ * This project is copylefted.  You may freely use, distribute, and modify this software, to the extent permitted by law, so long as you do not attempt to claim such activities are condoned by the author, you distribute the license file with any distributions of this software, you release any modifications under a similar license, and you do not attempt to claim that modified software is the original software.
+ *
+ * This license does not apply to software created with the API of this software (thought it does apply to the API itself); it also does not apply to any rule files, all of which must be placed in the public domain.
+ *
+ * This software links to zlib, which is under the zlib license, available at https://www.zlib.net/zlib_license.html.
+ *
+ * This software dynamically links to SDL2, which is under a separate instance of the zlib license, available at https://libsdl.org/license.php.
+ *
+ * This software dynamically links to libgcrypt, which is under the GNU LGPL2.1+, available at https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=COPYING;h=ccbbaf61b794c7aaea10dffb486095fdc8f3a44a;hb=HEAD.
+ *
+ * This license does not apply to trademarks or patents.
+ *
+ * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
+
+/* This file runs an API-using program in a child process.  The game and the program talk through two single-producer, single-consumer rings in shared memory—one for requests, one for replies—next to a copy of the board that the game refreshes before each request.  Each side spins for a moment when it's expecting a message, then sleeps on a futex, so a round trip takes a few microseconds when things are busy and no CPU at all when they aren't.  If the program crashes, only its process dies, and the game notices the next time it waits for a reply.
+ *
+ * When reading this file, you are expected to have access to and generally understand the following documents:
+ * 	· Latest draft of C2x:  http://www.open-std.org/JTC1/SC22/WG14/www/docs/n2596.pdf
+ * 	· The Clang compiler user(?) manual:  https://clang.llvm.org/docs/UsersManual.html
+ * 	· The latest POSIX specification:  https://pubs.opengroup.org/onlinepubs/9699919799/mindex.html
+ * 	· The Linux manpages for futex(2) and prctl(2), since those aren't in POSIX. */
+
+#define _GNU_SOURCE /* For `syscall()`, `MAP_ANONYMOUS`, and `prctl()`. */
+
+#include "Isolate.h"
+#include "Board.h"
+#include "Program.h"
+#include "Trace.h"
+#include <linux/futex.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+enum { ring_size = 16 }; /* Only one request is ever outstanding, so this is plenty. */
+static const size_t key_room = 64;
+/* How many times to check for a message before going to sleep.  This is a few microseconds' worth. */
+static const int spins = 4096;
+
+struct message {
+	uint32_t sequence;
+	bool quit; /* Requests only. */
+	enum gake_direction direction; /* Replies only. */
+};
+
+struct ring {
+	_Alignas(64) _Atomic uint32_t head; /* Only written by the producer. */
+	_Alignas(64) _Atomic uint32_t tail; /* Only written by the consumer. */
+	_Atomic uint32_t sleeping; /* Set by the consumer while it's waiting on `head`. */
+	struct message slots[ring_size];
+};
+
+struct channel {
+	struct ring requests;
+	struct ring replies;
+};
+
+static size_t round_up(size_t n)
+{
+	return (n + 63) & ~(size_t)63;
+}
+
+static void futex_wait(_Atomic uint32_t * word, uint32_t value, int ms)
+{
+	struct timespec timeout = { ms / 1000, ms % 1000 * 1000000 };
+	syscall(SYS_futex, (void *)word, FUTEX_WAIT, value, ms < 0 ? NULL : &timeout, NULL, 0);
+}
+
+static void futex_wake(_Atomic uint32_t * word)
+{
+	syscall(SYS_futex, (void *)word, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+static bool ring_push(struct ring * ring, struct message message)
+{
+	uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+	if (head - atomic_load_explicit(&ring->tail, memory_order_acquire) >= ring_size)
+		return 0;
+	ring->slots[head % ring_size] = message;
+	atomic_store(&ring->head, head + 1);
+	/* This and the store to `sleeping` in `ring_wait()` are both sequentially consistent, so either the consumer sees the new head or we see that it's asleep. */
+	if (atomic_load(&ring->sleeping))
+		futex_wake(&ring->head);
+	return 1;
+}
+
+static bool ring_pop(struct ring * ring, struct message * message)
+{
+	uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+	if (atomic_load_explicit(&ring->head, memory_order_acquire) == tail)
+		return 0;
+	*message = ring->slots[tail % ring_size];
+	atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+	return 1;
+}
+
+/* Returns whether there's something to pop.  A negative `ms` waits forever. */
+static bool ring_wait(struct ring * ring, int ms)
+{
+	uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+	for (register int i = 0; i < spins; i++)
+		if (atomic_load_explicit(&ring->head, memory_order_acquire) != tail)
+			return 1;
+	atomic_store(&ring->sleeping, 1);
+	uint32_t head = atomic_load(&ring->head);
+	if (head == tail)
+		futex_wait(&ring->head, head, ms);
+	atomic_store(&ring->sleeping, 0);
+	return atomic_load_explicit(&ring->head, memory_order_acquire) != tail;
+}
+
+/* The child isn't the game, so it shouldn't act like it:  a crash should just kill it, and the signals meant for the game should be left to the game. */
+static void reset_signals(void)
+{
+	const int defaults[] = {SIGABRT, SIGBUS, SIGFPE, SIGILL, SIGSEGV, SIGSYS, SIGTERM, SIGUSR1, 0};
+	const int ignored[] = {SIGHUP, SIGINT, SIGQUIT, SIGUSR2, 0};
+	for (register unsigned i = 0; defaults[i] != 0; i++)
+		sigaction(defaults[i], &(struct sigaction){ .sa_handler = SIG_DFL }, NULL);
+	for (register unsigned i = 0; ignored[i] != 0; i++)
+		sigaction(ignored[i], &(struct sigaction){ .sa_handler = SIG_IGN }, NULL);
+}
+
+_Noreturn static void serve(struct isolation * isolation, const struct program * program, pid_t parent)
+{
+	prctl(PR_SET_PDEATHSIG, SIGKILL);
+	if (getppid() != parent)
+		_exit(0); /* The game died before we could ask to die with it. */
+	reset_signals();
+	trace_enter(program->trace);
+	struct channel * channel = isolation->channel;
+	for (;;){
+		struct message request;
+		while (!ring_pop(&channel->requests, &request))
+			ring_wait(&channel->requests, -1);
+		if (request.quit)
+			_exit(0); /* Not `exit()`; the game's `atexit()` handlers and buffers are none of our business. */
+		struct gake_newstate move = {};
+		program_call(program, isolation->state, &move);
+		ring_push(&channel->replies, (struct message){ .sequence = request.sequence, .direction = move.direction });
+	}
+}
+
+/* This has to be called before any threads that might be holding a lock are started, since only the thread that calls `fork()` makes it into the child, and whatever the others held stays held there.  The logging thread is the exception:  it's started first, but its lock is taken around `fork()` by the `pthread_atfork()` handlers in `Source/Logging.c`, and the child logs without it.  Chunked boards (see `Source/Board.h`) aren't supported, since their chunks come and go as the snake moves and there'd be no good way to keep them in one mapping. */
+bool isolation_start(struct isolation * isolation, const struct program * program, int width, int height)
+{
+	uint32_t cells = (uint32_t)width * height;
+	if (cells > BOARD_FLAT_CELLS)
+		return 0;
+	uint32_t capacity = 1;
+	while (capacity < cells)
+		capacity <<= 1; /* The same as in `board_init()`. */
+	*isolation = (struct isolation){
+		.words = (cells + 63) / 64,
+		.capacity = capacity,
+		.synced = -2 /* Nothing's been copied yet. */
+	};
+	size_t state_at = round_up(sizeof (struct channel));
+	size_t keys_at = state_at + round_up(sizeof (struct gake_curstate));
+	size_t deltas_at = keys_at + round_up(key_room);
+	size_t occupancy_at = deltas_at + round_up(sizeof ((struct board *)NULL)->changes);
+	size_t body_at = occupancy_at + round_up(isolation->words * sizeof (uint64_t));
+	isolation->size = body_at + capacity * sizeof (uint32_t);
+
+	void * shared = mmap(NULL, isolation->size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (shared == MAP_FAILED)
+		return 0;
+	isolation->channel = shared;
+	isolation->state = (struct gake_curstate *)((char *)shared + state_at);
+	isolation->keys = (char *)shared + keys_at;
+	if (program->deltas)
+		isolation->deltas = (struct gake_delta *)((char *)shared + deltas_at);
+	isolation->occupancy = (uint64_t *)((char *)shared + occupancy_at);
+	isolation->body = (uint32_t *)((char *)shared + body_at);
+
+	pid_t parent = getpid();
+	pid_t pid = fork();
+	if (pid == 0)
+		serve(isolation, program, parent);
+	if (pid < 0){
+		munmap(shared, isolation->size);
+		*isolation = (struct isolation){};
+		return 0;
+	}
+	isolation->pid = pid;
+	return 1;
+}
+
+/* This doesn't reap the child, so its PID can't be reused while `isolation_kill()` might still be aimed at it. */
+static bool dead(struct isolation * isolation)
+{
+	siginfo_t info = {};
+	if (waitid(P_PID, isolation->pid, &info, WEXITED | WNOHANG | WNOWAIT) != 0)
+		return 1;
+	if (info.si_pid == 0)
+		return 0;
+	isolation->signal = info.si_code == CLD_EXITED ? 0 : info.si_status;
+	return 1;
+}
+
+/* Copies the board into the shared mapping.  If the board has taken exactly one step since the last copy, only what that step changed is copied; otherwise, only the cells of the ring that the snake is in are copied, and they stay at the same indices. */
+static bool describe(struct isolation * isolation, const struct board * board, const char * keys)
+{
+	if (board->occupancy == NULL || ((size_t)board->width * board->height + 63) / 64 > isolation->words || board->mask + 1 > isolation->capacity)
+		return 0;
+	struct gake_curstate * state = isolation->state;
+	board_describe(board, state, isolation->deltas != NULL);
+	if (board->frames > 0 && board->frames == isolation->synced + 1){
+		for (register uint32_t i = 0; i < board->change_count; i++){
+			uint32_t cell = board->changes[i].cell;
+			if (board->changes[i].change == gake_tail_removed)
+				isolation->occupancy[cell >> 6] &= ~((uint64_t)1 << (cell & 63));
+			else if (board->changes[i].change == gake_head_added)
+				isolation->occupancy[cell >> 6] |= (uint64_t)1 << (cell & 63);
+		}
+		isolation->body[board->head] = board->body[board->head];
+	} else {
+		memcpy(isolation->occupancy, board->occupancy, isolation->words * sizeof (uint64_t));
+		uint32_t tail = (board->head - board->length + 1) & board->mask;
+		if (tail <= board->head){
+			memcpy(&isolation->body[tail], &board->body[tail], board->length * sizeof (uint32_t));
+		} else {
+			memcpy(&isolation->body[tail], &board->body[tail], (board->mask + 1 - tail) * sizeof (uint32_t));
+			memcpy(isolation->body, board->body, (board->head + 1) * sizeof (uint32_t));
+		}
+	}
+	isolation->synced = board->frames;
+	state->occupancy = isolation->occupancy;
+	state->body = isolation->body;
+	if (isolation->deltas != NULL){
+		memcpy(isolation->deltas, board->changes, board->change_count * sizeof (struct gake_delta));
+		state->deltas = isolation->deltas;
+	}
+	state->keys = isolation->keys;
+	strncpy(isolation->keys, keys, key_room - 1);
+	return 1;
+}
+
+/* Returns 0 if the program's process has died, in which case `signal` says what killed it. */
+bool isolation_call(struct isolation * isolation, const struct board * board, const char * keys, struct gake_newstate * move)
+{
+	struct channel * channel = isolation->channel;
+	if (!describe(isolation, board, keys)){
+		move->direction = gake_ahead;
+		return 1;
+	}
+	uint32_t sequence = ++isolation->sent;
+	ring_push(&channel->requests, (struct message){ .sequence = sequence });
+	for (;;){
+		struct message reply;
+		while (ring_pop(&channel->replies, &reply)){
+			if (reply.sequence == sequence){
+				move->direction = reply.direction;
+				return 1;
+			}
+		}
+		/* Waking up every so often is how a crash gets noticed. */
+		if (!ring_wait(&channel->replies, 5) && dead(isolation))
+			return 0;
+	}
+}
+
+/* Safe to call from any thread, even while another is waiting on the program in `isolation_call()`; that call will then return 0. */
+void isolation_kill(struct isolation * isolation)
+{
+	if (isolation->pid > 0)
+		kill(isolation->pid, SIGKILL);
+}
+
+void isolation_stop(struct isolation * isolation)
+{
+	if (isolation->pid <= 0)
+		return;
+	ring_push(&isolation->channel->requests, (struct message){ .quit = 1 });
+	for (register int i = 0; i < 100 && !dead(isolation); i++)
+		nanosleep(&(struct timespec){ 0, 1000000 }, NULL);
+	isolation_kill(isolation);
+	waitpid(isolation->pid, NULL, 0);
+	munmap(isolation->channel, isolation->size);
+	*isolation = (struct isolation){};
+}
@@ -0,0 +1,56 @@
+/* LICENSE
+ *
+ * Copyright © 2021 Blue-Maned_Hawk.  All rights reserved.
+ *
+ * This software should have come with a file called LICENSE.  In case of any difference between this comment and that file, that file is the authority.  (If you did not recieve that file, it's a violation of the license.  Please report it to me.)
+ *
+ * This project is copylefted.  You may freely use, distribute, and modify this software, to the extent permitted by law, so long as you do not attempt to claim such activities are condoned by the author, you distribute the license file with any distributions of this software, you release any modifications under a similar license, and you do not attempt to claim that modified software is the original software.
+ *
+ * This license does not apply to software created with the API of this software (thought it does apply to the API itself); it also does not apply to any rule files, all of which must be placed in the public domain.
+ *
+ * This software links to zlib, which is under the zlib license, available at https://www.zlib.net/zlib_license.html.
+ *
+ * This software dynamically links to SDL2, which is under a separate instance of the zlib license, available at https://libsdl.org/license.php.
+ *
+ * This software dynamically links to libgcrypt, which is under the GNU LGPL2.1+, available at https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=COPYING;h=ccbbaf61b794c7aaea10dffb486095fdc8f3a44a;hb=HEAD.
+ *
+ * This license does not apply to trademarks or patents.
+ *
+ * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
+
+#ifndef ISOLATE_H
+#define ISOLATE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include "Board.h"
+#include "../gake.h"
+
+struct channel;
+struct program;
+
+/* A program running in a process of its own, so that it can't take the game down with it when it crashes.  Everything the two processes share lives in one mapping made before the fork, so it's at the same address in both and the pointers in the state can be used as they are. */
+struct isolation {
+	pid_t pid; /* 0 when the program isn't isolated. */
+	struct channel * channel;
+	size_t size;
+	struct gake_curstate * state; /* All of these point into the mapping. */
+	char * keys;
+	struct gake_delta * deltas; /* NULL unless the program wants them. */
+	uint64_t * occupancy;
+	uint32_t * body;
+	size_t words;
+	uint32_t capacity;
+	uint32_t sent;
+	long long synced; /* The frame that the board in the mapping is from. */
+	int signal; /* What killed the process, once it's dead. */
+};
+
+extern bool isolation_start(struct isolation * isolation, const struct program * program, int width, int height);
+extern bool isolation_call(struct isolation * isolation, const struct board * board, const char * keys, struct gake_newstate * move);
+extern void isolation_kill(struct isolation * isolation);
+extern void isolation_stop(struct isolation * isolation);
+
+#endif/*ndef ISOLATE_H*/
@@ -19,16 +19,27 @@
  * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
 
 /* This defines the logging subroutines for Gake, along with a couple subroutines to start and stop it.  The enums for priorities and categories are in `Logging.h`.  There is no critical priority—the only way to log a message with such a priority is by crashing the game (see `Crash.c`).
+ *
+ * Logging is done in two halves, so that the thread that logs a message pays as little as possible for it.  `logmsg()` only formats the message itself, straight into a fixed-size record in a ring, and notes the time and where it came from; a thread of its own takes the records back out in order and does the rest:  the timestamp, the priority and category, the escape codes, stderr, and compressing it into the logfile.  The ring is Dmitry Vyukov's bounded queue:  any number of threads can put records in without a lock (each slot has a sequence number that says whose turn it is), and only the logging thread takes them out.  When there's nothing to do, the logging thread sleeps on a futex, the same as in `Source/Isolate.c`.
+ *
+ * With `gake -L`, the logfile is binary (see `Source/Binlog.h`), and the thread that logs doesn't even format the message:  it only copies the arguments into the record, going by a list of their types that's worked out once for each format string.
+ *
+ * Other parts of the game can keep rings of their own, which the logging thread drains whenever it drains this one; that's how messages from programs get to the log, without the programs ever waiting on this ring (see `Source/Trace.c`).
+ *
+ * Before `setup_logging()` and after `halt_logging()`, and in the child processes that `isolation_start()` makes, there's no logging thread, so messages are written out straight away instead.
  *
  * When reading this file, you are expected to have access to and generally understand the following documents:
  * 	· Latest draft of C2x:  http://www.open-std.org/JTC1/SC22/WG14/www/docs/n2596.pdf
  * 	· The Clang compiler user(?) manual:  https://clang.llvm.org/docs/UsersManual.html
- * 	· The latest POSIX specification:  https://pubs.opengroup.org/onlinepubs/9699919799/mindex.html */
+ * 	· The latest POSIX specification:  https://pubs.opengroup.org/onlinepubs/9699919799/mindex.html
+ * 	· The Linux manpage for futex(2), since that isn't in POSIX.
+ * 	· Dmitry Vyukov's description of the queue:  https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue */
 
 
-#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE /* For `syscall()`. */
 
 #include "Logging.h"
+#include "Binlog.h"
 #include <stdarg.h>
 #include <stdio.h>
 #include <time.h>
@@ -38,6 +49,13 @@
 #include <errno.h>
 #include <sys/stat.h>
 #include <dirent.h>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 static gzFile logfile = NULL;
 static const char categories[8][64] = {
@@ -46,10 +64,276 @@ static const char categories[8][64] = {
 	"Environment",
 	"Runtime Checks",
 	"API",
-	"API-Using Programs"
+	"API-Using Programs",
+	"Timing"
 };
 
-void setup_logging(void)
+/* A record is a whole cache line's worth of them, so two threads logging at once never write to the same line. */
+enum { ring_records = 4096, record_bytes = 512 };
+
+struct record {
+	_Atomic uint64_t sequence; /* Its position in the ring when it's free, and one more than that once it's been filled in. */
+	int64_t time_ns; /* `CLOCK_MONOTONIC`. */
+	uint32_t format; /* `BINLOG_TEXT` if `text` is the message, or which of `format_strings` the arguments in `text` are for. */
+	int8_t priority;
+	uint8_t category;
+	uint16_t length;
+	char text[record_bytes - 24];
+};
+
+static _Alignas(64) struct record records[ring_records];
+static _Alignas(64) _Atomic uint64_t ring_tail; /* The next position to be filled in.  Written by every thread that logs. */
+static _Alignas(64) uint64_t ring_head; /* The next position to be written out.  Only touched by whoever's writing. */
+static _Atomic uint32_t sleeping; /* Set by the logging thread while it's waiting on `wakeups`. */
+static _Atomic uint32_t wakeups;
+static _Atomic uint64_t dropped; /* Messages that there wasn't room for.  Only debugging and information messages are ever dropped; see `vlogmsg()`. */
+static atomic_bool threaded; /* Whether messages go into the ring, rather than straight out. */
+static atomic_bool stopping;
+static pthread_t logging_thread;
+static bool binary; /* `gake -L` */
+static int64_t clock_offset; /* `CLOCK_REALTIME` minus `CLOCK_MONOTONIC`. */
+static int64_t started_realtime;
+static int64_t started_monotonic;
+
+/* The format strings that messages have been logged with, for binary logs.  A format's number is the slot it's in, which is found by hashing its address; the format strings are all string literals, so a message always has the same one, and looking its number up is only a few loads.  `format_types` is what `binlog_types()` made of it, or `!` if it can't be kept as arguments. */
+enum { format_slots = 4096 };
+static _Atomic(const char *) format_strings[format_slots];
+static char format_types[format_slots][BINLOG_MAX_ARGUMENTS + 1];
+static atomic_bool format_ready[format_slots];
+static bool format_written[format_slots]; /* Whether the format has gone into the logfile yet.  Only touched by whoever's writing. */
+static bool text_written;
+static _Atomic(struct log_source *) sources;
+
+/* Held by whoever's writing messages out, whether that's the logging thread or a message being written out straight away, and across `fork()`, so that a child never starts with a message half written. */
+static pthread_mutex_t writing = PTHREAD_MUTEX_INITIALIZER;
+
+static void futex_wait(_Atomic uint32_t * word, uint32_t value, int ms)
+{
+	struct timespec timeout = { ms / 1000, ms % 1000 * 1000000 };
+	syscall(SYS_futex, (void *)word, FUTEX_WAIT_PRIVATE, value, &timeout, NULL, 0);
+}
+
+static void futex_wake(_Atomic uint32_t * word)
+{
+	syscall(SYS_futex, (void *)word, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+static void wake_logger(void)
+{
+	atomic_fetch_add(&wakeups, 1);
+	futex_wake(&wakeups);
+}
+
+/* Copies `text` into `out` without any escape codes, which are only any use on a terminal.  Returns how long the result is. */
+static size_t strip_escapes(char * out, const char * text, size_t length)
+{
+	size_t kept = 0;
+	for (register size_t i = 0; i < length; i++){
+		if (text[i] != '\e'){
+			out[kept++] = text[i];
+			continue;
+		}
+		while (i < length && text[i] != 'm')
+			i++;
+	}
+	return kept;
+}
+
+/* What's been written out but not yet handed to stderr and zlib.  stderr isn't buffered, so this turns a system call per message into one per batch of them. */
+static char terminal_out[65536];
+static char file_out[65536];
+static size_t terminal_used;
+static size_t file_used;
+
+static void flush_out(void)
+{
+	fwrite(terminal_out, 1, terminal_used, stderr);
+	if (logfile != NULL && file_used != 0)
+		gzwrite(logfile, file_out, file_used);
+	terminal_used = 0;
+	file_used = 0;
+}
+
+static int64_t clock_ns(clockid_t clock)
+{
+	struct timespec now;
+	clock_gettime(clock, &now);
+	return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/* Format strings can be any length, so they're written straight to the logfile instead of going through `file_out`. */
+static void write_format(uint32_t format, const char * string)
+{
+	size_t length = strlen(string);
+	if (length > UINT16_MAX)
+		length = UINT16_MAX;
+	struct binlog_entry entry = { .format = format, .length = length, .kind = bk_format };
+	flush_out();
+	gzwrite(logfile, &entry, sizeof entry);
+	gzwrite(logfile, string, length);
+}
+
+/* Writes a record out to stderr and the logfile (by way of `terminal_out` and `file_out`).  Only ever called with `writing` held, which is also what makes the cached timestamp safe. */
+static void write_record(const struct record * record)
+{
+	static time_t last_second = -1;
+	static char time_str[64];
+	const char * priority_str;
+	const char * plain_priority;
+	switch (record->priority){
+	/* See `Logging.h`—this makes debug messages only show in debug builds. This is kinda a silly way to do it, but oh well. */
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wswitch"
+	case -1:
+		return;
+	case 1:
+		priority_str = "\e[32mDEBUG\e[m";
+		plain_priority = "DEBUG";
+		break;
+#pragma clang diagnostic pop
+	case lp_info:
+		priority_str = "\e[37mINFO\e[m";
+		plain_priority = "INFO";
+		break;
+	case lp_note:
+		priority_str = "\e[36mNOTICE\e[m";
+		plain_priority = "NOTICE";
+		break;
+	case lp_warn:
+		priority_str = "\e[33mWARNING\e[m";
+		plain_priority = "WARNING";
+		break;
+	case lp_err:
+		priority_str = "\e[31mERROR\e[m";
+		plain_priority = "ERROR";
+		break;
+	default:
+		priority_str = "\e[34m???????\e[m";
+		plain_priority = "???????";
+		break;
+	}
+
+	/* Messages logged before `setup_logging()` still need a time of day. */
+	if (clock_offset == 0)
+		clock_offset = clock_ns(CLOCK_REALTIME) - clock_ns(CLOCK_MONOTONIC);
+	/* `localtime_r()` is the slowest part of this, and the time only shows seconds, so it's only done once a second. */
+	time_t the_time = (record->time_ns + clock_offset) / 1000000000;
+	if (the_time != last_second){
+		struct tm broken_down;
+		if (localtime_r(&the_time, &broken_down) == NULL || strftime(time_str, sizeof time_str, "%T", &broken_down) == 0)
+			sprintf(time_str, "??:??:??");
+		last_second = the_time;
+	}
+
+	const char * category_str = record->category < sizeof categories / sizeof *categories ? categories[record->category] : "???";
+	const char * text = record->text;
+	size_t text_length = record->length;
+	char formatted[sizeof record->text];
+	if (record->format != BINLOG_TEXT){
+		text_length = binlog_format(formatted, sizeof formatted, format_strings[record->format], format_types[record->format], (const uint8_t *)record->text, record->length);
+		text = formatted;
+	}
+	/* A line is never more than the text and a bit, so as long as there's that much room, nothing here can run off the end. */
+	const size_t line_room = sizeof record->text + 128;
+	if (sizeof terminal_out - terminal_used < line_room || sizeof file_out - file_used < line_room)
+		flush_out();
+	terminal_used += snprintf(terminal_out + terminal_used, line_room, "[%s] %s (%s:)  %.*s\n", time_str, priority_str, category_str, (int)text_length, text);
+	if (logfile != NULL && binary){
+		if (record->format == BINLOG_TEXT ? !text_written : !format_written[record->format]){
+			write_format(record->format, record->format == BINLOG_TEXT ? "%s" : format_strings[record->format]);
+			*(record->format == BINLOG_TEXT ? &text_written : &format_written[record->format]) = 1;
+		}
+		uint16_t text_bytes = record->length;
+		bool as_text = record->format == BINLOG_TEXT;
+		struct binlog_entry entry = {
+			.time_ns = record->time_ns,
+			.format = record->format,
+			.length = record->length + (as_text ? sizeof text_bytes : 0),
+			.kind = bk_message,
+			.priority = record->priority,
+			.category = record->category
+		};
+		memcpy(file_out + file_used, &entry, sizeof entry);
+		file_used += sizeof entry;
+		if (as_text){
+			memcpy(file_out + file_used, &text_bytes, sizeof text_bytes);
+			file_used += sizeof text_bytes;
+		}
+		memcpy(file_out + file_used, record->text, record->length);
+		file_used += record->length;
+	} else if (logfile != NULL){
+		file_used += snprintf(file_out + file_used, line_room, "[%s] %s (%s:)  ", time_str, plain_priority, category_str);
+		file_used += strip_escapes(file_out + file_used, record->text, record->length);
+		file_out[file_used++] = '\n';
+	}
+}
+
+/* Writes out every record that's ready, in order, then whatever the sources have, and says how many messages were dropped since last time, if any were.  Only ever called with `writing` held.  Returns how many records there were. */
+static size_t drain(void)
+{
+	size_t written = 0;
+	for (;;){
+		struct record * record = &records[ring_head % ring_records];
+		if (atomic_load_explicit(&record->sequence, memory_order_acquire) != ring_head + 1)
+			break;
+		write_record(record);
+		atomic_store_explicit(&record->sequence, ring_head + ring_records, memory_order_release);
+		ring_head++;
+		written++;
+	}
+	for (struct log_source * source = atomic_load(&sources); source != NULL; source = source->next)
+		source->drain(source, atomic_load(&stopping));
+	uint64_t lost = atomic_exchange_explicit(&dropped, 0, memory_order_relaxed);
+	if (lost != 0){
+		struct record note = { .time_ns = clock_ns(CLOCK_MONOTONIC), .format = BINLOG_TEXT, .priority = lp_warn, .category = lc_debug };
+		note.length = snprintf(note.text, sizeof note.text, "The log couldn't keep up, so %llu message%s dropped.", (unsigned long long)lost, lost == 1 ? " was" : "s were");
+		write_record(&note);
+	}
+	flush_out();
+	return written;
+}
+
+static bool ring_ready(void)
+{
+	return atomic_load(&records[ring_head % ring_records].sequence) == ring_head + 1;
+}
+
+static void * logger(void *)
+{
+	for (;;){
+		pthread_mutex_lock(&writing);
+		drain();
+		pthread_mutex_unlock(&writing);
+		if (atomic_load(&stopping) && !ring_ready())
+			return NULL;
+		/* The same handshake as `ring_wait()` in `Source/Isolate.c`:  this and the stores in `vlogmsg()` are sequentially consistent, so either this sees the new record or the thread that logged it sees that this is asleep.  The timeout is only a backstop. */
+		uint32_t seen = atomic_load(&wakeups);
+		atomic_store(&sleeping, 1);
+		if (!ring_ready() && !atomic_load(&stopping))
+			futex_wait(&wakeups, seen, 100);
+		atomic_store(&sleeping, 0);
+	}
+}
+
+/* `fork()` is only ever called by `isolation_start()`, and the child never comes back to the game; it has no logging thread, so it writes its messages out straight away, and only to stderr, since the logfile is the game's. */
+static void before_fork(void)
+{
+	pthread_mutex_lock(&writing);
+}
+
+static void after_fork_parent(void)
+{
+	pthread_mutex_unlock(&writing);
+}
+
+static void after_fork_child(void)
+{
+	atomic_store(&threaded, 0);
+	logfile = NULL;
+	pthread_mutex_unlock(&writing);
+}
+
+void setup_logging(bool binary_log)
 {
 	char logfilename[128];
 	char time_str[64];
@@ -86,13 +370,86 @@ void setup_logging(void)
 	}
 	closedir(logdir);
 	memset(logfilename, 0, sizeof logfilename);
-	snprintf(logfilename, sizeof logfilename, "%s/Gake/%s.txt.gz", state, time_str);
+	snprintf(logfilename, sizeof logfilename, "%s/Gake/%s.%s.gz", state, time_str, binary_log ? "bin" : "txt");
 	logfile = gzopen(logfilename, "wb9");
+
+	started_realtime = clock_ns(CLOCK_REALTIME);
+	started_monotonic = clock_ns(CLOCK_MONOTONIC);
+	clock_offset = started_realtime - started_monotonic;
+	if (binary_log && logfile != NULL){
+		struct binlog_header header = { .magic = "GAKEBLG", .version = 1, .realtime_ns = started_realtime, .monotonic_ns = started_monotonic };
+		pthread_mutex_lock(&writing);
+		gzwrite(logfile, &header, sizeof header);
+		pthread_mutex_unlock(&writing);
+		binary = 1;
+	}
+
+	for (register uint64_t i = 0; i < ring_records; i++)
+		atomic_init(&records[i].sequence, i);
+	atomic_store(&stopping, 0);
+	pthread_atfork(before_fork, after_fork_parent, after_fork_child);
+	if (pthread_create(&logging_thread, NULL, logger, NULL) == 0)
+		atomic_store(&threaded, 1);
 }
 
+/* Writes out everything that's still in the ring and closes the logfile. */
 void halt_logging(void)
 {
-	gzclose(logfile);
+	if (atomic_exchange(&threaded, 0)){
+		atomic_store(&stopping, 1);
+		wake_logger();
+		pthread_join(logging_thread, NULL);
+		/* Anything that was put in the ring just before `threaded` was cleared. */
+		pthread_mutex_lock(&writing);
+		drain();
+		pthread_mutex_unlock(&writing);
+	}
+	pthread_mutex_lock(&writing);
+	if (logfile != NULL)
+		gzclose(logfile);
+	logfile = NULL;
+	pthread_mutex_unlock(&writing);
+}
+
+/* `halt_logging()` for the crash handler, which can't wait for just anything:  the thread that crashed might be holding `writing` (it might even be the logging thread), and the logging thread can't be joined from a signal handler.  But `crash()` is mostly called from ordinary code, while the logging thread is likely to be partway through writing, and all it needs is a moment to finish; so `writing` is tried for up to `crash_wait_ns`, after which whatever's in the ring is written out, the logfile is closed, and `writing` is kept for good, so that nothing touches the logfile after it's been closed.  If `writing` never comes free, the ring is given up on, and the logfile is finished where it is with `gzflush()`, which doesn't close it, so that whoever's holding `writing` doesn't find it gone; anything that they write after that starts a new gzip member, which is still a valid file.  Anything logged after this waits forever, which is fine, since the game is on its way out.  (`nanosleep()` is safe to call from a signal handler.) */
+static const long crash_wait_ns = 250000000, crash_retry_ns = 1000000;
+
+void crash_logging(void)
+{
+	atomic_store(&threaded, 0);
+	for (register long waited = 0; pthread_mutex_trylock(&writing) != 0; waited += crash_retry_ns){
+		if (waited >= crash_wait_ns){
+			if (logfile != NULL)
+				gzflush(logfile, Z_FINISH);
+			return;
+		}
+		nanosleep(&(struct timespec){ .tv_nsec = crash_retry_ns }, NULL);
+	}
+	drain();
+	if (logfile != NULL)
+		gzclose(logfile);
+	logfile = NULL;
+}
+
+/* Sources are only ever added, so they can be kept as a list that's pushed onto without a lock, and the logging thread can go through it without one. */
+void logging_add_source(struct log_source * source)
+{
+	source->next = atomic_load(&sources);
+	while (!atomic_compare_exchange_weak(&sources, &source->next, source));
+}
+
+/* The message is always kept as text, since the format strings that sources pass aren't all string literals. */
+[[gnu::format(printf, 4, 5)]] void logmsg_at(int64_t time_ns, enum log_priority priority, enum log_category category, const char * msg, ...)
+{
+	if ((int)priority == -1)
+		return;
+	struct record record = { .time_ns = time_ns, .format = BINLOG_TEXT, .priority = priority, .category = category };
+	va_list ap;
+	va_start(ap, msg);
+	int length = vsnprintf(record.text, sizeof record.text, msg, ap);
+	va_end(ap);
+	record.length = length < 0 ? 0 : (size_t)length < sizeof record.text ? (size_t)length : sizeof record.text - 1;
+	write_record(&record);
 }
 
 /* Note that `logmsg` assumes that you've sanitized the string before you log it. */
@@ -104,62 +461,128 @@ void halt_logging(void)
 	va_end(ap);
 }
 
-void vlogmsg(enum log_priority priority, enum log_category category, char * msg, va_list arg)
+/* Returns `BINLOG_TEXT` if `format` can't be given a number, because it can't be kept as arguments or there are already too many formats. */
+static uint32_t format_number(const char * format)
 {
-	char final_message[1024], time_str[64], priority_str[32], category_str[32];
-	switch (priority){
-	/* See `Logging.h`—this makes debug messages only show in debug builds. This is kinda a silly way to do it, but oh well. */
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wswitch"
-	case -1:
-		goto end;
-	case 1:
-		sprintf(priority_str, "\e[32mDEBUG\e[m");
-		break;
-#pragma clang diagnostic pop
-	case lp_info:
-		sprintf(priority_str, "\e[37mINFO\e[m");
-		break;
-	case lp_note:
-		sprintf(priority_str, "\e[36mNOTICE\e[m");
-		break;
-	case lp_warn:
-		sprintf(priority_str, "\e[33mWARNING\e[m");
-		break;
-	case lp_err:
-		sprintf(priority_str, "\e[31mERROR\e[m");
-		break;
-	default:
-		sprintf(priority_str, "\e[34m???????\e[m");
-		break;
+	uint32_t slot = ((uint64_t)(uintptr_t)format * 0x9e3779b97f4a7c15) >> 52;
+	for (register uint32_t probes = 0; probes < format_slots; probes++, slot = (slot + 1) % format_slots){
+		const char * there = atomic_load_explicit(&format_strings[slot], memory_order_acquire);
+		if (there == NULL && atomic_compare_exchange_strong(&format_strings[slot], &there, format)){
+			if (!binlog_types(format, format_types[slot]))
+				strcpy(format_types[slot], "!");
+			atomic_store_explicit(&format_ready[slot], 1, memory_order_release);
+			there = format;
+		}
+		if (there == format){
+			/* Another thread might have only just claimed the slot. */
+			while (!atomic_load_explicit(&format_ready[slot], memory_order_acquire))
+				sched_yield();
+			return format_types[slot][0] == '!' ? BINLOG_TEXT : slot;
+		}
 	}
+	return BINLOG_TEXT;
+}
 
-	sprintf(category_str, "%s", categories[category]);
+/* Copies the arguments, as `types` says, into `out`.  Whatever doesn't fit is left off, and a string that doesn't fit is cut short.  Returns how many bytes there are. */
+static uint16_t pack(char * out, size_t room, const char * types, va_list arg)
+{
+	size_t used = 0;
+#define PACK(type, value) do {\
+		type packed = (value);\
+		if (room - used < sizeof packed)\
+			return used;\
+		memcpy(out + used, &packed, sizeof packed);\
+		used += sizeof packed;\
+	} while (0)
+	for (; *types != '\0'; types++){
+		switch (*types){
+		case 'i':
+			PACK(int32_t, va_arg(arg, int));
+			break;
+		case 'l':
+			PACK(int64_t, va_arg(arg, long long));
+			break;
+		case 'd':
+			PACK(double, va_arg(arg, double));
+			break;
+		case 'L':
+			PACK(long double, va_arg(arg, long double));
+			break;
+		case 'p':
+			PACK(uint64_t, (uintptr_t)va_arg(arg, void *));
+			break;
+		case 's':
+			{
+				const char * string = va_arg(arg, const char *);
+				if (string == NULL)
+					string = "(null)";
+				if (room - used < sizeof (uint16_t))
+					return used;
+				uint16_t length = strnlen(string, room - used - sizeof length);
+				PACK(uint16_t, length);
+				memcpy(out + used, string, length);
+				used += length;
+			}
+			break;
+		}
+	}
+#undef PACK
+	return used;
+}
 
-	time_t the_time = time(NULL);
-	if (strftime(time_str, 64, "%T", localtime(&the_time)) == 0){
-		sprintf(time_str, "??:??:??");
-	}
-
-	char formatted_msg[512];
-	vsnprintf(formatted_msg, 512, msg, arg);
-	snprintf(final_message, sizeof final_message, "[%s] %s (%s:)  %s\n", time_str, priority_str, category_str, formatted_msg);
-	fprintf(stderr, "%s", final_message);
-	if (logfile != NULL){ // Might not want to have this be checked every time this function is called, but I don't think there's a way around it.
-		char * found_escape;
-		/* Wtf‽ */
-		while (NULL != (found_escape = strchr(final_message, (int)'\e'))){
-			short j = 0;
-			do {
-				j++;
-			} while (*(found_escape + j) != 'm');
-			for (int k = 0; k <= j; k++)
-				*(found_escape + k) = ' ';
+static void fill(struct record * record, const char * msg, va_list arg)
+{
+	record->format = binary ? format_number(msg) : BINLOG_TEXT;
+	if (record->format != BINLOG_TEXT){
+		record->length = pack(record->text, sizeof record->text, format_types[record->format], arg);
+		return;
+	}
+	int length = vsnprintf(record->text, sizeof record->text, msg, arg);
+	record->length = length < 0 ? 0 : (size_t)length < sizeof record->text ? (size_t)length : sizeof record->text - 1;
+}
+
+/* This is the only part of logging that the thread that logs pays for:  the time, the formatting of the message itself (or, for a binary log, copying its arguments), and claiming a record.  When the ring is full, debugging and information messages are dropped (and counted), but anything more important waits for room. */
+void vlogmsg(enum log_priority priority, enum log_category category, char * msg, va_list arg)
+{
+	if ((int)priority == -1)
+		return;
+	int64_t time_ns = clock_ns(CLOCK_MONOTONIC);
+
+	if (!atomic_load_explicit(&threaded, memory_order_relaxed)){
+		struct record record = { .time_ns = time_ns, .priority = priority, .category = category };
+		fill(&record, msg, arg);
+		pthread_mutex_lock(&writing);
+		write_record(&record);
+		flush_out();
+		pthread_mutex_unlock(&writing);
+		return;
+	}
+
+	uint64_t position = atomic_load_explicit(&ring_tail, memory_order_relaxed);
+	struct record * record;
+	for (;;){
+		record = &records[position % ring_records];
+		int64_t difference = (int64_t)(atomic_load_explicit(&record->sequence, memory_order_acquire) - position);
+		if (difference == 0){
+			if (atomic_compare_exchange_weak_explicit(&ring_tail, &position, position + 1, memory_order_relaxed, memory_order_relaxed))
+				break;
+		} else if (difference < 0){
+			if (priority <= lp_info){
+				atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+				return;
+			}
+			wake_logger();
+			sched_yield();
+			position = atomic_load_explicit(&ring_tail, memory_order_relaxed);
+		} else {
+			position = atomic_load_explicit(&ring_tail, memory_order_relaxed);
 		}
-		gzprintf(logfile, "%s", final_message);
-		/* zlib's manual states that `gzflush()` should only be called "when strictly necessary", stating that it will degrade performance if called too often.  I'm not sure whether it's best to use it like this. */
-		gzflush(logfile, Z_NO_FLUSH);
 	}
-end:
-	((void)0);
+	record->time_ns = time_ns;
+	record->priority = priority;
+	record->category = category;
+	fill(record, msg, arg);
+	atomic_store(&record->sequence, position + 1);
+	if (atomic_load(&sleeping))
+		wake_logger();
 }
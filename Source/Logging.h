@@ -22,6 +22,8 @@
 #define LOGGING_H
 
 #include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
 
 enum log_priority {
 #ifdef GAKE_DEBUG
@@ -43,13 +45,26 @@ enum log_category {
 	lc_checks = 3,
 	lc_api = 4,
 	lc_apiprgm = 5,
-	/* More categories will prove necessary.  If you add a new category here, be sure to update the list in `Source/Logging.c`, too. */
+	lc_timing = 6,
+	/* More categories will prove necessary.  If you add a new category here, be sure to update the lists in `Source/Logging.c` and `Tools/LogRead.c`, too. */
 };
 
-extern void setup_logging(void);
+/* `binary_log` makes the logfile binary; see `Source/Binlog.h`. */
+extern void setup_logging(bool binary_log);
 extern void halt_logging(void);
+extern void crash_logging(void);
 /* Keep in mind that this function is not sanitized—you'll need to do that yourself. */
 extern void logmsg(enum log_priority priority, enum log_category category, char * msg, ...);
 extern void vlogmsg(enum log_priority priority, enum log_category category, char * msg, va_list arg);
 
+/* Something that keeps messages of its own until the logging thread comes for them, like the rings in `Source/Trace.c`.  `drain` is called by the logging thread every time it wakes up, and hands each message over with `logmsg_at()`; `last` is set once the log is being stopped, and this is the last chance to say anything.  Sources can't be taken away again. */
+struct log_source {
+	void (* drain)(struct log_source * source, bool last);
+	struct log_source * next;
+};
+
+extern void logging_add_source(struct log_source * source);
+/* Only for a source's `drain`.  `time_ns` is from `timing_now()`. */
+extern void logmsg_at(int64_t time_ns, enum log_priority priority, enum log_category category, const char * msg, ...);
+
 #endif/*ndef LOGGING_H*/
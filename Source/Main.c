@@ -48,25 +48,60 @@
 #include "Setup.h"
 #include "SDL2/SDL_image.h"
 #include "State.h"
+#include "Board.h"
+#include "Headless.h"
+#include "Isolate.h"
+#include "Pack.h"
+#include "Playback.h"
+#include "Program.h"
+#include "Reload.h"
+#include "Replay.h"
+#include "Sweep.h"
+#include "Schedule.h"
+#include "Timing.h"
+#include "Trace.h"
+#include <stdint.h>
+#include "../gake.h"
 
 static const int screenwidth = 640;
 static const int screenheight = 480;
 
-struct newboard {
-	int dummy;
-};
+/* This is the same as Google Snake's default ("medium") board, unless `-g` says otherwise. */
+static int boardwidth = 17;
+static int boardheight = 15;
+static enum gake_topology boardtopology = gake_plane; /* `-w` */
 
-struct curboard {
-	long long frame;
-	char keys[];
-};
+static uint64_t random_seed(void)
+{
+	uint64_t seed = 0;
+	FILE * random = fopen("/dev/urandom", "rb");
+	if (random != NULL){
+		fread(&seed, sizeof seed, 1, random);
+		fclose(random);
+	}
+	return seed;
+}
+
+/* A program that's still in the middle of a turn (one that's stuck, or that's been left running at exit) is left out, since its worker could be adding to its histogram right now.  The pool's lock is what makes the others safe to read:  a worker records how long a turn took before it says that it's done. */
+static void dump_timings(struct pool * pool, const struct program * programs, short count)
+{
+	char name[1100];
+	timing_dump();
+	for (register short i = 0; i < count; i++){
+		if (pool_busy(pool, i)){
+			logmsg(lp_info, lc_misc, "Program %s is still in the middle of a turn, so its timings are left out.", programs[i].name);
+			continue;
+		}
+		snprintf(name, sizeof name, "Program %s", programs[i].name);
+		histogram_log(&programs[i].timing, name);
+	}
+}
 
 int main(int argc, char ** argv)
 {
 	short gpcount = 0;
-	char prgm_names[8][1024];
-	struct newboard (*programs[8])(struct curboard);
-	void * tables[8];
+	struct program programs[8] = {};
+	struct pool pool;
 
 	SDL_Window * window;
 	SDL_Renderer * renderer;
@@ -77,27 +112,52 @@ int main(int argc, char ** argv)
 	bool exit = 0;
 	struct mouse the_mouse;
 
-	long long ticks = 0;
 	long long frames = 0;
-	long long over_frames = 0;
-
-	struct newboard new_board [[maybe_unused]] ;
-	struct curboard cur_board;
-	char keys[] = "";
-
-	enum state the_state;
-	SDL_Keycode key = SDLK_SPACE;
+	struct schedule schedule;
+	enum schedule_mode schedule_mode = sm_realtime;
+	int per_frame = 1;
+	uint64_t budget_ns = 20000000; /* Comfortably inside the 27 ms that a whole tick gets, so that the game keeps up with real time. */
+
+	char keys[64] = "";
+	struct board player_board = {};
+	enum gake_direction player_move = gake_ahead;
+	bool headless = 0;
+	size_t games = 1;
+	bool sweep = 0;
+	uint64_t first_seed = 0, last_seed = 0;
+	char * sweep_file = "Gake_Sweep.bin";
+	bool isolate = 0;
+	char * replay_filename = NULL;
+	struct replay_file replays = {};
+	struct replay player_replay = {};
+	char * playback_filename = NULL;
+	uint64_t playback_game = 0;
+	struct replay_reader playback = {};
+	struct replay_cursor * cursor = NULL; /* Only when a replay's being watched. */
+	struct reload reload = { .fd = -1 };
+	char * pack_filename = "/usr/local/share/Gake/Assets/Gake.pak";
+	struct pack pack = {};
+	int status = 0;
+
+	enum state the_state = menu;
+	enum state last_state = menu;
+	SDL_Keycode key = SDLK_UNKNOWN;
 
 	SDL_Surface * menu_assets[3];
 	SDL_Surface * game_assets[4];
 
+	uint64_t started_ns = timing_now(), lap_ns = started_ns;
+
 	install_signals();
 
 	bool * too_many = calloc(1, sizeof (bool));
 	bool * nonprgms = calloc(1, sizeof (bool));
+	bool bad_grid = 0;
+	bool bad_topology = 0;
+	bool binary_log = 0;
 
 	/* I intend to move this into `Source/Setup.c` at some point, but for now, I just want to get vN.1 out. */
-	for (signed char opts = 0; opts != -1; opts = getopt(argc, argv, "?hv-il:")){
+	for (signed char opts = 0; opts != -1; opts = getopt(argc, argv, "?hv-il:Hb:S:o:f:u:t:Ir:p:a:g:w:L")){
 		switch (opts){
 		case 0:
 			break;
@@ -117,7 +177,21 @@ int main(int argc, char ** argv)
 			"Options available:\n"
 			"\t\e[1m-v\e[m: \tdisplay the version.\n"
 			"\t\e[1m-h\e[m or \e[1m-?\e[m: \tdisplay this help blurb.\n"
-			"\t\e[1m-l\e[m \e[4m<API-using–program>\e[m: \tload the program for usage.  Up to 8 programs can be loaded at a time, though overusage of computing resources can lead to crashing.  Programs can also be loaded from within the application.\n"
+			"\t\e[1m-l\e[m \e[4m<API-using–program>\e[m: \tload the program for usage.  Up to 8 programs can be loaded at a time, though a program that takes too long will be skipped, and eventually unloaded.  Programs can also be loaded from within the application.\n"
+			"\t\e[1m-H\e[m: \trun headlessly:  don't open a window, just play one game with each loaded program as fast as possible, then exit.\n"
+			"\t\e[1m-b\e[m \e[4m<count>\e[m: \tin headless mode, have each program play this many games at once, starting from consecutive seeds.\n"
+			"\t\e[1m-S\e[m \e[4m<first>\e[m:\e[4m<last>\e[m: \tplay one game per seed from \e[4m<first>\e[m to \e[4m<last>\e[m with each loaded program, on every core, without opening a window.\n"
+			"\t\e[1m-o\e[m \e[4m<file>\e[m: \twrite the results of \e[1m-S\e[m to this file instead of \e[4mGake_Sweep.bin\e[m.\n"
+			"\t\e[1m-f\e[m \e[4m<ticks>\e[m: \tfast-forward:  run this many ticks of the game for every frame drawn.\n"
+			"\t\e[1m-u\e[m \e[4m<ticks>\e[m: \trun the game as fast as possible, only drawing a frame every this many ticks (or never, with 0).\n"
+			"\t\e[1m-t\e[m \e[4m<microseconds>\e[m: \thow long each program may take each frame before it's skipped (20000 by default).\n"
+			"\t\e[1m-I\e[m: \trun each program in a process of its own, so that it can crash without taking the game with it.\n"
+			"\t\e[1m-r\e[m \e[4m<file>\e[m: \trecord every game that's played to this file.\n"
+			"\t\e[1m-p\e[m \e[4m<file>\e[m[:\e[4m<game>\e[m]: \twatch the games recorded in this file, starting from the given one (the first, by default); with \e[1m-H\e[m, play them all back as fast as possible and check that they end the way they did.\n"
+			"\t\e[1m-a\e[m \e[4m<pack>\e[m: \tuse the textures in this asset pack instead of the installed one.\n"
+			"\t\e[1m-g\e[m \e[4m<width>\e[mx\e[4m<height>\e[m: \tplay on a board this size, from 5x3 up to 65535x65535 (17x15 by default).\n"
+			"\t\e[1m-w\e[m \e[4m<topology>\e[m: \twhat the edges of the board do:  \e[4mplane\e[m (walls, the default), \e[4mtorus\e[m, \e[4mklein_bottle\e[m, \e[4mcross_surface\e[m, or \e[4msphere\e[m (only on a square board), or Golly's letter for one of them.\n"
+			"\t\e[1m-L\e[m: \twrite the log in binary, which is quicker to write and to search; read it with \e[1mTools/LogRead.elf\e[m.\n"
 			"\n"
 			"For more information, please see the manpage (available with \e[1mman gake\e[m, if installed).\n"
 			"\n"
@@ -134,33 +208,100 @@ int main(int argc, char ** argv)
 			if (gpcount >= 8){
 				*too_many = 1;
 			} else {
-				void * table = dlopen(optarg, RTLD_LAZY | RTLD_LOCAL);
-				if (table != NULL){
-					struct newboard (*gake_main)(struct curboard) = dlsym(table, "gake_main");
-					if (gake_main == NULL){
-						*nonprgms = 1;
-					} else {
-						strcpy(prgm_names[gpcount], optarg);
-						gpcount++;
-					}
-					dlclose(table);
+				/* Each program is only opened this once; relocating a big one isn't free. */
+				struct program_code code;
+				if (strlen(optarg) < sizeof programs[gpcount].name && program_open(&code, optarg)){
+					program_use(&programs[gpcount], &code);
+					strcpy(programs[gpcount].name, optarg);
+					gpcount++;
 				} else {
 					*nonprgms = 1;
 				}
 			}
 			break;
+		case 'H':
+			headless = 1;
+			break;
+		case 'b':
+			games = strtoull(optarg, NULL, 0);
+			if (games == 0)
+				games = 1;
+			break;
+		case 'S':
+			{
+				char * colon;
+				first_seed = strtoull(optarg, &colon, 0);
+				last_seed = *colon == ':' ? strtoull(colon + 1, NULL, 0) : first_seed;
+				sweep = 1;
+				headless = 1;
+			}
+			break;
+		case 'o':
+			sweep_file = optarg;
+			break;
+		case 'f':
+			schedule_mode = sm_fast;
+			per_frame = atoi(optarg) > 0 ? atoi(optarg) : 1;
+			break;
+		case 'u':
+			schedule_mode = sm_uncapped;
+			per_frame = atoi(optarg) > 0 ? atoi(optarg) : 0;
+			break;
+		case 't':
+			if (strtoull(optarg, NULL, 0) > 0)
+				budget_ns = strtoull(optarg, NULL, 0) * 1000;
+			break;
+		case 'I':
+			isolate = 1;
+			break;
+		case 'r':
+			replay_filename = optarg;
+			break;
+		case 'a':
+			pack_filename = optarg;
+			break;
+		case 'g':
+			{
+				char * cross;
+				long width = strtol(optarg, &cross, 10);
+				long height = *cross == 'x' ? strtol(cross + 1, NULL, 10) : 0;
+				if (board_size_ok(width, height)){
+					boardwidth = width;
+					boardheight = height;
+				} else {
+					bad_grid = 1;
+				}
+			}
+			break;
+		case 'L':
+			binary_log = 1;
+			break;
+		case 'w':
+			if (!board_topology_named(optarg, &boardtopology))
+				bad_topology = 1;
+			break;
+		case 'p':
+			playback_filename = optarg;
+			/* Filenames can have colons in them too, so only a number at the very end counts as a game. */
+			char * colon = strrchr(optarg, ':');
+			if (colon != NULL && colon[1] != '\0' && strspn(colon + 1, "0123456789") == strlen(colon + 1)){
+				playback_game = strtoull(colon + 1, NULL, 10);
+				*colon = '\0';
+			}
+			break;
 		}
 	}
 
-	setup_logging();
+	setup_logging(binary_log);
 
 	logmsg(lp_info, lc_misc, "Gake has been started!");
 	logmsg(lp_info, lc_misc, "This is Gake version N.0, semantic version 0.0.0, compiled on %s at %s.", __DATE__, __TIME__);
 
 	debug_notice();
+	timing_lap("Reading the options, opening the programs, and starting the log", &lap_ns);
 
 	logmsg(lp_debug, lc_checks, "Beginning checks…");
-	switch (run_checks()){
+	switch (run_checks(headless)){
 	case -1:
 		battery_checks = 1;
 	case 0:
@@ -172,6 +313,7 @@ int main(int argc, char ** argv)
 		crash(0xD, "No other details.");
 	}
 	logmsg(lp_info, lc_checks, "All checks have passed!  Continuing as normal…");
+	timing_lap("Checking the assets and the battery", &lap_ns);
 
 	if (*nonprgms){
 		if (gpcount <= 0)
@@ -183,42 +325,134 @@ int main(int argc, char ** argv)
 	if (*too_many)
 		logmsg(lp_err, lc_api, "You have requested too many programs to be loaded.  Additional programs have been ignored.  (You can free program space and reload these programs from inside the game.)");
 	free(too_many);
+	if (bad_grid)
+		logmsg(lp_err, lc_misc, "The board size you asked for doesn't make sense, so the board will be %dx%d.", boardwidth, boardheight);
+	else if ((uint32_t)boardwidth * boardheight > BOARD_FLAT_CELLS)
+		logmsg(lp_info, lc_misc, "The board is %dx%d, so it'll be stored in chunks as the snake gets to them.", boardwidth, boardheight);
+	/* A sphere can only be checked once the size is known, since `-g` can come after `-w`. */
+	if (!board_topology_ok(boardtopology, boardwidth, boardheight)){
+		logmsg(lp_err, lc_misc, "A %s has to be square, so the board will be a plane.", board_topology_name(boardtopology));
+		boardtopology = gake_plane;
+	} else if (bad_topology){
+		logmsg(lp_err, lc_misc, "The topology you asked for doesn't exist, so the board will be a %s.", board_topology_name(boardtopology));
+	}
 
 	if (gpcount >= 1){
 		logmsg(lp_info, lc_api, "Loading programs from the command line…");
 		for (register short i = 0; i < gpcount; i++){
-			tables[i] = dlopen(prgm_names[i], RTLD_NOW | RTLD_LOCAL);
-			programs[i] = dlsym(tables[i], "gake_main");
-			logmsg(lp_debug, lc_api, "Loaded program %s.", prgm_names[i]);
+			if (programs[i].main == NULL)
+				logmsg(lp_note, lc_api, "Program %s was built against an older version of gake.h; it will still work, but it'll be a little slower.", programs[i].name);
+			if ((programs[i].trace = trace_open(programs[i].name)) == NULL)
+				logmsg(lp_warn, lc_api, "There's no room for a log for program %s, so whatever it logs will be ignored.", programs[i].name);
+			logmsg(lp_debug, lc_api, "Loaded program %s.", programs[i].name);
 		}
 		logmsg(lp_info, lc_api, "All programs have been loaded!");
 	}
 
+	if (replay_filename != NULL && replay_open(&replays, replay_filename))
+		logmsg(lp_info, lc_misc, "Recording replays to %s.", replay_filename);
+
+	if (headless){
+		logmsg(lp_info, lc_timing, "Gake started up in %.3f ms.", (timing_now() - started_ns) / 1e6);
+		if (isolate)
+			logmsg(lp_note, lc_api, "Programs can't be isolated in headless mode, so they'll run inside the game instead.");
+		if (playback_filename != NULL){
+			status = !run_playback(playback_filename);
+		} else if (gpcount <= 0){
+			logmsg(lp_err, lc_misc, "Headless mode needs at least one program to play the game.");
+		} else if (sweep){
+			run_sweep(programs, gpcount, boardwidth, boardheight, boardtopology, first_seed, last_seed, sweep_file, replay_filename != NULL ? &replays : NULL);
+		} else {
+			run_headless(programs, gpcount, boardwidth, boardheight, boardtopology, random_seed(), games, replay_filename != NULL ? &replays : NULL);
+		}
+		replay_close(&replays);
+		for (register short i = 0; i < gpcount; i++){
+			dlclose(programs[i].table);
+		}
+		logmsg(lp_info, lc_misc, "Exiting Gake…");
+		halt_logging();
+		return status;
+	}
+
 	logmsg(lp_debug, lc_env, "Loading textures…");
-	IMG_Init(IMG_INIT_PNG);
-	SDL_Surface * textures = IMG_Load("/usr/local/share/Gake/Assets/Textures.png");
+	/* The textures in the pack are already decoded, so the surfaces just point into it and nothing is copied; the PNG is only decoded if there's no pack, or it's missing some of them. */
+	bool packed = pack_map(&pack, pack_filename);
+#define PACK_ASSET(game_state, n)\
+	const struct pack_entry * game_state ## _entry_ ## n = packed ? pack_find(&pack, #game_state "/" #n) : NULL;\
+	game_state ## _assets[n] = game_state ## _entry_ ## n != NULL && game_state ## _entry_ ## n->format == pf_rgba32 ? SDL_CreateRGBSurfaceWithFormatFrom((void *)(pack.data + game_state ## _entry_ ## n->offset), game_state ## _entry_ ## n->width, game_state ## _entry_ ## n->height, 32, game_state ## _entry_ ## n->pitch, SDL_PIXELFORMAT_RGBA32) : NULL;\
+	packed &= game_state ## _assets[n] != NULL
+	PACK_ASSET(menu, 0);
+	PACK_ASSET(menu, 1);
+	PACK_ASSET(menu, 2);
+	PACK_ASSET(game, 0);
+	PACK_ASSET(game, 1);
+	PACK_ASSET(game, 2);
+	PACK_ASSET(game, 3);
+	if (!packed){
+		logmsg(lp_note, lc_env, "The textures couldn't all be found in the asset pack %s, so they'll be loaded from the PNG instead.", pack_filename);
+		for (register short i = 0; i < 3; i++)
+			SDL_FreeSurface(menu_assets[i]);
+		for (register short i = 0; i < 4; i++)
+			SDL_FreeSurface(game_assets[i]);
+		pack_unmap(&pack);
+		IMG_Init(IMG_INIT_PNG);
+		SDL_Surface * textures = IMG_Load("/usr/local/share/Gake/Assets/Textures.png");
 #define LOAD_ASSET(game_state, state_line, n)\
-	game_state ## _assets[n] = SDL_CreateRGBSurfaceWithFormat(0, 8, 8, 32, SDL_PIXELFORMAT_RGBA32);\
-	SDL_BlitSurface(textures, &(SDL_Rect){ n * 8, state_line * 8, 8, 8}, game_state ## _assets[n], NULL)
-	LOAD_ASSET(menu, 1, 0);
-	LOAD_ASSET(menu, 1, 1);
-	LOAD_ASSET(menu, 1, 2);
-	LOAD_ASSET(game, 0, 0);
-	LOAD_ASSET(game, 0, 1);
-	LOAD_ASSET(game, 0, 2);
-	LOAD_ASSET(game, 0, 3);
-	SDL_FreeSurface(textures);
-	IMG_Quit();
+		game_state ## _assets[n] = SDL_CreateRGBSurfaceWithFormat(0, 8, 8, 32, SDL_PIXELFORMAT_RGBA32);\
+		SDL_BlitSurface(textures, &(SDL_Rect){ n * 8, state_line * 8, 8, 8}, game_state ## _assets[n], NULL)
+		LOAD_ASSET(menu, 1, 0);
+		LOAD_ASSET(menu, 1, 1);
+		LOAD_ASSET(menu, 1, 2);
+		LOAD_ASSET(game, 0, 0);
+		LOAD_ASSET(game, 0, 1);
+		LOAD_ASSET(game, 0, 2);
+		LOAD_ASSET(game, 0, 3);
+		SDL_FreeSurface(textures);
+		IMG_Quit();
+	}
 	logmsg(lp_debug, lc_env, "Textures loaded!");
+	timing_lap("Loading the textures", &lap_ns);
+
+	/* This has to happen before the programs' threads (or SDL's) are started; see `isolation_start()`.  The logging thread is already running, which is only safe because of the `pthread_atfork()` handlers in `Source/Logging.c`. */
+	for (register short i = 0; isolate && i < gpcount; i++){
+		if (isolation_start(&programs[i].isolation, &programs[i], boardwidth, boardheight))
+			logmsg(lp_debug, lc_api, "Program %s is running in process %d.", programs[i].name, (int)programs[i].isolation.pid);
+		else
+			logmsg(lp_err, lc_api, "Could not start a process for program %s, so it will run inside the game instead.", programs[i].name);
+	}
+
+	if (!pool_start(&pool, programs, gpcount, budget_ns))
+		logmsg(lp_err, lc_api, "Could not start threads for the programs, so they won't be run.");
+	else if (reload_start(&reload, programs, gpcount))
+		logmsg(lp_debug, lc_api, "Watching the programs for rebuilds.");
+
+	timing_lap("Starting the programs", &lap_ns);
+
+	if (playback_filename != NULL){
+		cursor = calloc(1, sizeof *cursor);
+		if (cursor == NULL || !replay_map(&playback, playback_filename)){
+			logmsg(lp_err, lc_misc, "Could not open the replay file %s, so there's nothing to watch.", playback_filename);
+			free(cursor);
+			cursor = NULL;
+		}
+	}
 
 	SDL_Init(SDL_INIT_VIDEO);
 	window = SDL_CreateWindow("Gake", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, screenwidth, screenheight, 0);
-	renderer = SDL_CreateRenderer(window, -1, 0);
+	/* With vsync, frames are drawn at whatever rate the display runs at; how fast the game itself goes is up to the schedule. */
+	renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_PRESENTVSYNC);
+	if (renderer == NULL)
+		renderer = SDL_CreateRenderer(window, -1, 0);
+	timing_lap("Starting SDL and opening the window", &lap_ns);
+	logmsg(lp_info, lc_timing, "Gake started up in %.3f ms.", (timing_now() - started_ns) / 1e6);
+
+	schedule_init(&schedule, schedule_mode, per_frame);
 
 	for (;;){
 		frames++;
-		ticks = SDL_GetTicks64();
 		strcpy(keys, "");
+		key = SDLK_UNKNOWN;
+		uint64_t phase_start = timing_now();
 
 		/* May want to put this in a separate subroutine. */
 		while (SDL_PollEvent(&event)){
@@ -227,26 +461,132 @@ int main(int argc, char ** argv)
 				exit++;
 				break;
 			case SDL_KEYDOWN:
-				if (event.key.keysym.sym < 0x7f && event.key.keysym.sym > 8)
+				/* Escape being held down after it left the game would quit from the menu. */
+				if (event.key.repeat && event.key.keysym.sym == SDLK_ESCAPE)
+					break;
+				key = event.key.keysym.sym;
+				switch (key){
+				case SDLK_UP:
+					player_move = gake_up;
+					break;
+				case SDLK_DOWN:
+					player_move = gake_down;
+					break;
+				case SDLK_LEFT:
+					player_move = gake_left;
+					break;
+				case SDLK_RIGHT:
+					player_move = gake_right;
+					break;
+				}
+				if (key < 0x7f && key > 8 && strlen(keys) < sizeof keys - 1)
 					strncat(keys, (char *)&event.key.keysym.sym, 1);
 				break;
 			}
 		}
 		the_mouse.mask = SDL_GetMouseState(&the_mouse.x, &the_mouse.y);
+		timing_record(tp_events, timing_now() - phase_start);
 		if (exit) break;
 
-		for (register short i = 0; i < gpcount; i++){
-			cur_board.frame = frames;
-			strcpy(cur_board.keys, keys);
-			new_board = programs[i](cur_board);
+		reload_poll(&reload, &pool, programs, gpcount);
+
+		if (timing_requested){
+			timing_requested = 0;
+			dump_timings(&pool, programs, gpcount);
+		}
+
+		/* Everybody starts from the same seed, so that the programs can be compared fairly. */
+		if (the_state == game && last_state != game){
+			uint64_t seed = random_seed();
+			replay_write(&player_replay, &player_board);
+			board_free(&player_board);
+			board_init(&player_board, boardwidth, boardheight, boardtopology, seed);
+			if (replays.file != NULL)
+				replay_begin(&replays, &player_replay, &player_board, seed, NULL);
+			for (register short i = 0; i < gpcount; i++){
+				if (pool_busy(&pool, i))
+					continue; /* Its worker is still using the board. */
+				replay_write(&programs[i].replay, &programs[i].board);
+				board_free(&programs[i].board);
+				board_init(&programs[i].board, boardwidth, boardheight, boardtopology, seed);
+				if (replays.file != NULL)
+					replay_begin(&replays, &programs[i].replay, &programs[i].board, seed, programs[i].name);
+			}
+			player_move = gake_ahead;
+			/* Each time the game is entered, the replay goes on to the next game in the file, and back around to the first one after the last. */
+			if (cursor != NULL && (!cursor->started || !replay_next(cursor)) && !replay_seek(cursor, &playback, playback_game, 0)){
+				logmsg(lp_err, lc_misc, "There's no game %llu in %s.", (unsigned long long)playback_game, playback_filename);
+				the_state = menu;
+			}
+		}
+		if (the_state == menu && last_state != menu)
+			render_menu_reset();
+		last_state = the_state;
+
+		/* Seeking only ever has to step from the nearest keyframe, so it's quick enough to do right here. */
+		if (the_state == game && cursor != NULL){
+			uint64_t at = cursor->board.frames, to = at;
+			uint64_t last = cursor->header.frames > 0 ? cursor->header.frames - 1 : 0; /* The frame after this one is where it ended. */
+			switch (key){
+			case SDLK_PAGEUP:
+				to = at > REPLAY_KEYFRAME_INTERVAL ? at - REPLAY_KEYFRAME_INTERVAL : 0;
+				break;
+			case SDLK_PAGEDOWN:
+				to = at + REPLAY_KEYFRAME_INTERVAL < last ? at + REPLAY_KEYFRAME_INTERVAL : last;
+				break;
+			case SDLK_HOME:
+				to = 0;
+				break;
+			case SDLK_END:
+				to = last;
+				break;
+			}
+			if (to != at)
+				replay_seek(cursor, &playback, cursor->game, to);
+		}
+
+		/* Only the first tick after the events were handled gets the keys. */
+		if (the_state == game){
+			for (register int ticks = schedule_ticks(&schedule); ticks > 0; ticks--){
+				uint64_t started = timing_now();
+				uint64_t waited = 0;
+				if (cursor != NULL){
+					replay_step(cursor);
+				} else {
+					waited = pool_run_frame(&pool, keys);
+					if (player_board.alive){
+						board_step(&player_board, player_move);
+						replay_frame(&player_replay, &player_board);
+					}
+				}
+				player_move = gake_ahead;
+				strcpy(keys, "");
+				timing_record(tp_tick, timing_now() - started);
+				schedule_tick_done(&schedule, started, waited);
+			}
+		} else {
+			/* Keep the schedule from thinking that it owes all of the time spent in the menu. */
+			schedule_init(&schedule, schedule_mode, per_frame);
 		}
 
+		/* A program that's gone over its budget might still be moving its snake, so until it's done, its board isn't looked at, and the last picture of it is drawn again.  Everything else carries on as usual. */
+		bool settled = cursor != NULL || gpcount < 1 || !pool_busy(&pool, 0);
+		const struct board * shown = cursor != NULL ? &cursor->board : gpcount >= 1 ? &programs[0].board : &player_board;
+
+		if (the_state == game && !schedule_render(&schedule)){
+			if (key == SDLK_ESCAPE || (settled && !shown->alive))
+				the_state = menu;
+			continue;
+		}
+
+		phase_start = timing_now();
 		SDL_SetRenderDrawColor(renderer, 0x00, 0x00, 0x00, 0xFF);
 		SDL_RenderClear(renderer);
 
 		switch (the_state){
 		case game:
-			the_state = render_game(frames, key, the_mouse, renderer, game_assets);
+			/* If any programs are loaded, the window shows the first one's game instead of the player's, and a replay that's being watched comes before either. */
+			the_state = render_game(frames, key, the_mouse, renderer, game_assets, settled ? shown : NULL);
 			break;
 		case menu:
 			the_state = render_menu(the_mouse, key, renderer, menu_assets);
@@ -259,25 +599,27 @@ int main(int argc, char ** argv)
 			break;
 		}
 
-		SDL_RenderPresent(renderer);
+		timing_record(tp_render, timing_now() - phase_start);
 
-		if ((SDL_GetTicks64() - ticks) > 27){
-			over_frames++;
-			if (over_frames % 36 == 0){
-				logmsg(lp_note, lc_env, "Slowdown detected.  Continued slowdown could result in a crash.");
-			}
-			if (over_frames > 360){
-				crash(0x0E, "No extra information.");
-			}
-		} else if (over_frames > 0){
-			over_frames--;
-		}
+		phase_start = timing_now();
+		SDL_RenderPresent(renderer);
+		timing_record(tp_present, timing_now() - phase_start);
 	}
 
 	logmsg(lp_info, lc_misc, "Exiting Gake…");
 
+	dump_timings(&pool, programs, gpcount);
+	reload_stop(&reload);
+	pool_stop(&pool);
+
 	for (register short i = 0; i < gpcount; i++){
-		dlclose(tables[i]);
+		if (pool_busy(&pool, i))
+			continue; /* See `pool_stop()`. */
+		isolation_stop(&programs[i].isolation);
+		replay_write(&programs[i].replay, &programs[i].board);
+		replay_free(&programs[i].replay);
+		board_free(&programs[i].board);
+		dlclose(programs[i].table);
 	}
 
 	for (register short i = 0; i < 3; i++){
@@ -287,7 +629,18 @@ int main(int argc, char ** argv)
 	for (register short i = 0; i < 4; i++){
 		SDL_FreeSurface(game_assets[i]);
 	}
-
+	pack_unmap(&pack); /* Only after the surfaces, which might point into it. */
+
+	replay_write(&player_replay, &player_board);
+	replay_free(&player_replay);
+	replay_close(&replays);
+	board_free(&player_board);
+	if (cursor != NULL)
+		replay_done(cursor);
+	free(cursor);
+	replay_unmap(&playback);
+
+	render_cleanup();
 	SDL_DestroyRenderer(renderer);
 	SDL_DestroyWindow(window);
 
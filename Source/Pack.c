@@ -0,0 +1,108 @@
+/* LICENSE
+ *
+ * Copyright © 2021 Blue-Maned_Hawk.  All rights reserved.
+ *
+ * This software should have come with a file called LICENSE.  In case of any difference between this comment and that file, that file is the authority.  (If you did not recieve that file, it's a violation of the license.  Please report it to me.)
+ *
+ * This project is copylefted.  You may freely use, distribute, and modify this software, to the extent permitted by law, so long as you do not attempt to claim such activities are condoned by the author, you distribute the license file with any distributions of this software, you release any modifications under a similar license, and you do not attempt to claim that modified software is the original software.
+ *
+ * This license does not apply to software created with the API of this software (thought it does apply to the API itself); it also does not apply to any rule files, all of which must be placed in the public domain.
+ *
+ * This software links to zlib, which is under the zlib license, available at https://www.zlib.net/zlib_license.html.
+ *
+ * This software dynamically links to SDL2, which is under a separate instance of the zlib license, available at https://libsdl.org/license.php.
+ *
+ * This software dynamically links to libgcrypt, which is under the GNU LGPL2.1+, available at https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=COPYING;h=ccbbaf61b794c7aaea10dffb486095fdc8f3a44a;hb=HEAD.
+ *
+ * This license does not apply to trademarks or patents.
+ *
+ * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
+
+/* This file reads asset packs (see `Source/Pack.h`).  The pack is mapped into memory once and never copied out of:  the textures in it are already in the format that SDL wants, so using one is just pointing at it.
+ *
+ * When reading this file, you are expected to have access to and generally understand the following documents:
+ * 	· Latest draft of C2x:  http://www.open-std.org/JTC1/SC22/WG14/www/docs/n2596.pdf
+ * 	· The Clang compiler user(?) manual:  https://clang.llvm.org/docs/UsersManual.html
+ * 	· The latest POSIX specification:  https://pubs.opengroup.org/onlinepubs/9699919799/mindex.html */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "Pack.h"
+#include "Logging.h"
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Checks the header and the index, and that every entry is inside the file; the data in each entry is only checked when it's looked up. */
+bool pack_map(struct pack * pack, const char * filename)
+{
+	*pack = (struct pack){};
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0)
+		return 0;
+	struct stat info;
+	if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof (struct pack_header)){
+		close(fd);
+		return 0;
+	}
+	void * data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		return 0;
+	pack->data = data;
+	pack->size = info.st_size;
+
+	struct pack_header header;
+	memcpy(&header, pack->data, sizeof header);
+	if (memcmp(header.magic, "GAKEPAK", 8) != 0 || header.version != 1 || header.entries > (pack->size - sizeof header) / sizeof (struct pack_entry)){
+		logmsg(lp_err, lc_env, "%s isn't an asset pack that this version of Gake can read.", filename);
+		pack_unmap(pack);
+		return 0;
+	}
+	pack->index = (const struct pack_entry *)(pack->data + sizeof header);
+	pack->entries = header.entries;
+	if (pack_checksum(pack->index, pack->entries * sizeof (struct pack_entry)) != header.index_checksum){
+		logmsg(lp_err, lc_env, "The index of the asset pack %s is damaged.", filename);
+		pack_unmap(pack);
+		return 0;
+	}
+	for (register uint32_t i = 0; i < pack->entries; i++){
+		const struct pack_entry * entry = &pack->index[i];
+		bool fits = entry->offset <= pack->size && entry->size <= pack->size - entry->offset && memchr(entry->name, '\0', sizeof entry->name) != NULL;
+		if (fits && entry->format == pf_rgba32)
+			fits = entry->pitch >= (uint64_t)entry->width * 4 && (uint64_t)entry->pitch * entry->height <= entry->size;
+		if (!fits){
+			logmsg(lp_err, lc_env, "Entry %u of the asset pack %s doesn't make sense.", i, filename);
+			pack_unmap(pack);
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/* Returns NULL if there's no such entry, or if its data is damaged. */
+const struct pack_entry * pack_find(const struct pack * pack, const char * name)
+{
+	for (register uint32_t i = 0; i < pack->entries; i++){
+		const struct pack_entry * entry = &pack->index[i];
+		if (strcmp(entry->name, name) != 0)
+			continue;
+		if (pack_checksum(pack->data + entry->offset, entry->size) != entry->checksum){
+			logmsg(lp_err, lc_env, "The asset %s in the asset pack is damaged.", name);
+			return NULL;
+		}
+		return entry;
+	}
+	return NULL;
+}
+
+void pack_unmap(struct pack * pack)
+{
+	if (pack->data != NULL)
+		munmap((void *)pack->data, pack->size);
+	*pack = (struct pack){};
+}
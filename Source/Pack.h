@@ -0,0 +1,74 @@
+/* LICENSE
+ *
+ * Copyright © 2021 Blue-Maned_Hawk.  All rights reserved.
+ *
+ * This software should have come with a file called LICENSE.  In case of any difference between this comment and that file, that file is the authority.  (If you did not recieve that file, it's a violation of the license.  Please report it to me.)
+ *
+ * This project is copylefted.  You may freely use, distribute, and modify this software, to the extent permitted by law, so long as you do not attempt to claim such activities are condoned by the author, you distribute the license file with any distributions of this software, you release any modifications under a similar license, and you do not attempt to claim that modified software is the original software.
+ *
+ * This license does not apply to software created with the API of this software (thought it does apply to the API itself); it also does not apply to any rule files, all of which must be placed in the public domain.
+ *
+ * This software links to zlib, which is under the zlib license, available at https://www.zlib.net/zlib_license.html.
+ *
+ * This software dynamically links to SDL2, which is under a separate instance of the zlib license, available at https://libsdl.org/license.php.
+ *
+ * This software dynamically links to libgcrypt, which is under the GNU LGPL2.1+, available at https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=COPYING;h=ccbbaf61b794c7aaea10dffb486095fdc8f3a44a;hb=HEAD.
+ *
+ * This license does not apply to trademarks or patents.
+ *
+ * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
+
+#ifndef PACK_H
+#define PACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* An asset pack is this header, then `entries` of `struct pack_entry`, then the data that they point to, each piece starting on a 64-byte boundary.  Images are stored already decoded, as RGBA with one byte per channel (what SDL calls `SDL_PIXELFORMAT_RGBA32`), so they can be used straight out of the file.  Everything is in the byte order of the machine that built the pack.  `Tools/Pack.c` builds them. */
+struct pack_header {
+	char magic[8]; /* "GAKEPAK" */
+	uint32_t version;
+	uint32_t entries;
+	uint64_t index_checksum; /* `pack_checksum()` of all of the entries. */
+};
+
+enum pack_format {
+	pf_raw = 0,
+	pf_rgba32 = 1
+};
+
+struct pack_entry {
+	char name[32]; /* Always terminated. */
+	uint32_t format;
+	uint32_t width; /* For images only; everything else has 0 for these. */
+	uint32_t height;
+	uint32_t pitch;
+	uint64_t offset; /* From the start of the file. */
+	uint64_t size;
+	uint64_t checksum; /* `pack_checksum()` of the data. */
+};
+
+/* This is FNV-1a.  It's only there to catch damage, not tampering, and it needs to be cheap enough to check every time the game starts. */
+static inline uint64_t pack_checksum(const void * data, size_t size)
+{
+	const uint8_t * bytes = data;
+	uint64_t hash = 0xcbf29ce484222325;
+	for (register size_t i = 0; i < size; i++)
+		hash = (hash ^ bytes[i]) * 0x100000001b3;
+	return hash;
+}
+
+/* A pack, mapped into memory. */
+struct pack {
+	const uint8_t * data;
+	size_t size;
+	const struct pack_entry * index;
+	uint32_t entries;
+};
+
+extern bool pack_map(struct pack * pack, const char * filename);
+extern const struct pack_entry * pack_find(const struct pack * pack, const char * name);
+extern void pack_unmap(struct pack * pack);
+
+#endif/*ndef PACK_H*/
@@ -0,0 +1,486 @@
+/* LICENSE
+ *
+ * Copyright © 2021 Blue-Maned_Hawk.  All rights reserved.
+ *
+ * This software should have come with a file called LICENSE.  In case of any difference between this comment and that file, that file is the authority.  (If you did not recieve that file, it's a violation of the license.  Please report it to me.)
+ *
+ * This project is copylefted.  You may freely use, distribute, and modify this software, to the extent permitted by law, so long as you do not attempt to claim such activities are condoned by the author, you distribute the license file with any distributions of this software, you release any modifications under a similar license, and you do not attempt to claim that modified software is the original software.
+ *
+ * This license does not apply to software created with the API of this software (thought it does apply to the API itself); it also does not apply to any rule files, all of which must be placed in the public domain.
+ *
+ * This software links to zlib, which is under the zlib license, available at https://www.zlib.net/zlib_license.html.
+ *
+ * This software dynamically links to SDL2, which is under a separate instance of the zlib license, available at https://libsdl.org/license.php.
+ *
+ * This software dynamically links to libgcrypt, which is under the GNU LGPL2.1+, available at https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=COPYING;h=ccbbaf61b794c7aaea10dffb486095fdc8f3a44a;hb=HEAD.
+ *
+ * This license does not apply to trademarks or patents.
+ *
+ * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
+
+/* This file plays back the replays recorded by `Source/Replay.c`.  The file is mapped into memory rather than read, so that jumping around in it costs nothing but the decompression.  To get to a frame, the index at the end of the file is searched for the last keyframe at or before it; inflation starts right there, since the compressor was flushed just before it, the board is loaded from the keyframe, and then it's stepped the rest of the way, which is never more than `REPLAY_KEYFRAME_INTERVAL` frames.  Games without keyframes are short, so they're found by reading through from the nearest place that is in the index.
+ *
+ * Since version 3, the games are in parts, mixed in with each other, so reading a game means reading its parts and skipping over everybody else's.  A game's first part always comes after the one before it's first part, but maybe before that game's last part, so while a game is being read, the place where the next one starts is kept if it's passed, and the next game is started from there.
+ *
+ * When reading this file, you are expected to have access to and generally understand the following documents:
+ * 	· Latest draft of C2x:  http://www.open-std.org/JTC1/SC22/WG14/www/docs/n2596.pdf
+ * 	· The Clang compiler user(?) manual:  https://clang.llvm.org/docs/UsersManual.html
+ * 	· The latest POSIX specification:  https://pubs.opengroup.org/onlinepubs/9699919799/mindex.html
+ * 	· The zlib manual:  https://zlib.net/manual.html */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "Playback.h"
+#include "Board.h"
+#include "Logging.h"
+#include "Replay.h"
+#include "Timing.h"
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "zlib.h"
+
+bool replay_map(struct replay_reader * reader, const char * filename)
+{
+	*reader = (struct replay_reader){};
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0)
+		return 0;
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size == 0){
+		close(fd);
+		return 0;
+	}
+	void * data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		return 0;
+	reader->data = data;
+	reader->size = info.st_size;
+	reader->compressed = info.st_size;
+
+	/* A file without an index (because it was never closed properly, say) can still be read, just not skipped through quickly. */
+	struct replay_index_tail tail;
+	if (reader->size >= sizeof tail){
+		memcpy(&tail, reader->data + reader->size - sizeof tail, sizeof tail);
+		if (memcmp(tail.magic, "GAKEIDX", 8) == 0 && tail.entries <= (reader->size - sizeof tail) / sizeof (struct replay_index_entry)){
+			reader->entries = tail.entries;
+			reader->compressed = reader->size - sizeof tail - tail.entries * sizeof (struct replay_index_entry);
+			reader->index = (const struct replay_index_entry *)(reader->data + reader->compressed);
+		}
+	}
+
+	char magic[sizeof REPLAY_PARTS_MAGIC] = "";
+	z_stream stream = {
+		.next_in = (Bytef *)reader->data,
+		.avail_in = reader->compressed > (1u << 30) ? (1u << 30) : reader->compressed,
+		.next_out = (Bytef *)magic,
+		.avail_out = sizeof magic
+	};
+	if (inflateInit2(&stream, 15 + 16) == Z_OK){
+		inflate(&stream, Z_NO_FLUSH);
+		inflateEnd(&stream);
+	}
+	reader->parts = memcmp(magic, REPLAY_PARTS_MAGIC, sizeof magic) == 0;
+	return 1;
+}
+
+void replay_unmap(struct replay_reader * reader)
+{
+	if (reader->data != NULL)
+		munmap((void *)reader->data, reader->size);
+	*reader = (struct replay_reader){};
+}
+
+static void forget_next(struct replay_cursor * cursor)
+{
+	if (cursor->next_saved)
+		inflateEnd(&cursor->next_stream);
+	cursor->next_saved = 0;
+}
+
+static bool pull(struct replay_cursor * cursor, void * out, uint64_t size);
+
+/* Starts inflating from `offset`:  as a gzip stream from the start of the file, or as raw deflate from a place in the index. */
+static bool start(struct replay_cursor * cursor, uint64_t offset)
+{
+	if (cursor->inflating)
+		inflateEnd(&cursor->stream);
+	forget_next(cursor);
+	cursor->inflating = 0;
+	cursor->at = cursor->have = 0;
+	cursor->run = 0;
+	cursor->moves_left = cursor->left = 0;
+	cursor->part_left = 0;
+	cursor->last_part = 0;
+	cursor->in_order = 0;
+	if (offset >= cursor->reader->compressed)
+		return 0;
+	cursor->stream = (z_stream){
+		.next_in = (Bytef *)cursor->reader->data + offset
+	};
+	cursor->in_left = cursor->reader->compressed - offset;
+	if (inflateInit2(&cursor->stream, offset == 0 ? 15 + 16 : -15) != Z_OK)
+		return 0;
+	cursor->inflating = 1;
+	return offset != 0 || !cursor->reader->parts || pull(cursor, NULL, sizeof REPLAY_PARTS_MAGIC);
+}
+
+static bool fill(struct replay_cursor * cursor)
+{
+	cursor->stream.next_out = cursor->buffer;
+	cursor->stream.avail_out = sizeof cursor->buffer;
+	while (cursor->stream.avail_out == sizeof cursor->buffer){
+		/* `avail_in` is only an `unsigned`, so a big enough file has to be handed over a piece at a time. */
+		if (cursor->stream.avail_in == 0 && cursor->in_left > 0){
+			cursor->stream.avail_in = cursor->in_left > (1u << 30) ? (1u << 30) : cursor->in_left;
+			cursor->in_left -= cursor->stream.avail_in;
+		}
+		int status = inflate(&cursor->stream, Z_NO_FLUSH);
+		if (status != Z_OK)
+			break; /* The end of the stream, or a broken one. */
+	}
+	cursor->at = 0;
+	cursor->have = sizeof cursor->buffer - cursor->stream.avail_out;
+	return cursor->have > 0;
+}
+
+/* Reads `size` bytes into `out`, or just skips them if `out` is NULL. */
+static bool pull(struct replay_cursor * cursor, void * out, uint64_t size)
+{
+	while (size > 0){
+		if (cursor->at == cursor->have && !fill(cursor))
+			return 0;
+		size_t chunk = cursor->have - cursor->at < size ? cursor->have - cursor->at : size;
+		if (out != NULL){
+			memcpy(out, cursor->buffer + cursor->at, chunk);
+			out = (char *)out + chunk;
+		}
+		cursor->at += chunk;
+		size -= chunk;
+	}
+	return 1;
+}
+
+/* Keeps where the game after this one starts, so that `replay_next()` can go back to it. */
+static void save_next(struct replay_cursor * cursor, const struct replay_part * part)
+{
+	if (inflateCopy(&cursor->next_stream, &cursor->stream) != Z_OK){
+		cursor->in_order = 0; /* So it has to be looked for from the index instead. */
+		return;
+	}
+	cursor->next_saved = 1;
+	cursor->next_in_left = cursor->in_left;
+	memcpy(cursor->next_buffer, cursor->buffer, sizeof cursor->buffer);
+	cursor->next_at = cursor->at;
+	cursor->next_have = cursor->have;
+	cursor->next_part = *part;
+}
+
+/* Starts reading `part`, which is the next part of the game that the cursor's on. */
+static void take_part(struct replay_cursor * cursor, const struct replay_part * part)
+{
+	cursor->part_left = part->bytes;
+	cursor->last_part = part->last;
+	if (part->frames >= cursor->header.frames){
+		cursor->header.frames = part->frames;
+		cursor->header.score = part->score;
+	}
+}
+
+/* Goes on to the next part of the game that the cursor's on, skipping the parts of every other game. */
+static bool next_part(struct replay_cursor * cursor)
+{
+	struct replay_part part;
+	for (;;){
+		if (!pull(cursor, &part, sizeof part))
+			return 0;
+		if (part.game == cursor->game)
+			break;
+		if (part.game == cursor->game + 1 && cursor->in_order && !cursor->next_saved)
+			save_next(cursor, &part);
+		if (!pull(cursor, NULL, part.bytes))
+			return 0;
+	}
+	take_part(cursor, &part);
+	return 1;
+}
+
+/* `pull()` for the bytes of the game that the cursor's on, which in a file in parts are spread out between the parts. */
+static bool pull_game(struct replay_cursor * cursor, void * out, uint64_t size)
+{
+	if (!cursor->reader->parts)
+		return pull(cursor, out, size);
+	while (size > 0){
+		if (cursor->part_left == 0){
+			if (cursor->last_part || !next_part(cursor))
+				return 0;
+			continue;
+		}
+		uint64_t chunk = cursor->part_left < size ? cursor->part_left : size;
+		if (!pull(cursor, out, chunk))
+			return 0;
+		if (out != NULL)
+			out = (char *)out + chunk;
+		cursor->part_left -= chunk;
+		size -= chunk;
+	}
+	return 1;
+}
+
+static bool read_varint(struct replay_cursor * cursor, uint64_t * value)
+{
+	*value = 0;
+	for (register unsigned shift = 0; shift < 64; shift += 7){
+		uint8_t byte;
+		if (cursor->moves_left == 0 || !pull_game(cursor, &byte, 1))
+			return 0;
+		cursor->moves_left--;
+		*value |= (uint64_t)(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+			return 1;
+	}
+	return 0;
+}
+
+/* With `load` unset, the keyframe is skipped, since stepping to it gives the same board anyway. */
+static bool next_segment(struct replay_cursor * cursor, bool load)
+{
+	struct replay_segment segment;
+	if (cursor->left < sizeof segment || !pull_game(cursor, &segment, sizeof segment))
+		return 0;
+	uint64_t size = (uint64_t)segment.state_bytes + segment.moves_bytes;
+	if (cursor->left - sizeof segment < size)
+		return 0;
+	cursor->left -= sizeof segment + size;
+	cursor->moves_left = segment.moves_bytes;
+	cursor->run = 0;
+	if (segment.state_bytes == 0){
+		board_free(&cursor->board);
+		return board_init(&cursor->board, cursor->header.width, cursor->header.height, cursor->header.rules, cursor->header.seed);
+	}
+	if (!load)
+		return pull_game(cursor, NULL, segment.state_bytes);
+	void * image = malloc(segment.state_bytes);
+	bool loaded = image != NULL && pull_game(cursor, image, segment.state_bytes) && board_load(&cursor->board, image, segment.state_bytes);
+	free(image);
+	return loaded;
+}
+
+/* The last entry in the index at or before `frame` of `game`, or -1 if there isn't one. */
+static ptrdiff_t find(const struct replay_reader * reader, uint64_t game, uint64_t frame)
+{
+	ptrdiff_t low = 0, high = reader->entries;
+	while (low < high){
+		ptrdiff_t middle = low + (high - low) / 2;
+		const struct replay_index_entry * entry = &reader->index[middle];
+		if (entry->game < game || (entry->game == game && entry->frame <= frame))
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	return low - 1;
+}
+
+/* Reads the header of a game and sets the board up at frame 0.  In a file in parts, that's the header of game `cursor->game`, which is looked for from wherever the cursor is, if it isn't already in the middle of its first part. */
+static bool begin_game(struct replay_cursor * cursor)
+{
+	struct replay_header * header = &cursor->header;
+	cursor->in_order = 1;
+	header->frames = 0;
+	if (!pull_game(cursor, header, sizeof *header) || memcmp(header->magic, "GAKERPL", 8) != 0)
+		return 0;
+	if (!board_size_ok(header->width, header->height) || !board_topology_ok(header->rules, header->width, header->height))
+		return 0;
+	size_t kept = header->name_length < sizeof cursor->name ? header->name_length : sizeof cursor->name - 1;
+	if (!pull_game(cursor, cursor->name, kept) || !pull_game(cursor, NULL, header->name_length - kept))
+		return 0;
+	cursor->name[kept] = '\0';
+	cursor->run = 0;
+	if (cursor->reader->parts != (header->version >= 3))
+		return 0;
+	switch (header->version){
+	case 1:
+		/* The first version didn't have segments; it was all moves, straight from the seed. */
+		cursor->left = 0;
+		cursor->moves_left = header->bytes;
+		board_free(&cursor->board);
+		return board_init(&cursor->board, header->width, header->height, header->rules, header->seed);
+	case 2:
+		cursor->left = header->bytes;
+		return next_segment(cursor, 0);
+	case 3:
+		/* A game in parts goes on until its last part, and if it's long enough to be in the index, the index says how long it was, which its parts so far might not. */
+		cursor->left = UINT64_MAX;
+		ptrdiff_t first = find(cursor->reader, cursor->game, 0);
+		if (first >= 0 && cursor->reader->index[first].game == cursor->game && cursor->reader->index[first].bytes != UINT64_MAX && cursor->reader->index[first].bytes > header->frames)
+			header->frames = cursor->reader->index[first].bytes;
+		return next_segment(cursor, 0);
+	default:
+		return 0;
+	}
+}
+
+static bool skip_game(struct replay_cursor * cursor)
+{
+	return pull(cursor, NULL, cursor->moves_left + cursor->left);
+}
+
+/* Puts the cursor at `frame` of `game`, or at the end of the game if it's not that long.  Returns 0 if there's no such game. */
+bool replay_seek(struct replay_cursor * cursor, const struct replay_reader * reader, uint64_t game, uint64_t frame)
+{
+	cursor->reader = reader;
+	cursor->started = 0;
+	cursor->game = game;
+	ptrdiff_t best = find(reader, game, frame);
+	if (best >= 0 && reader->index[best].game == game){
+		/* The game's in the index, so its header is at its first entry. */
+		const struct replay_index_entry * entry = &reader->index[best];
+		ptrdiff_t first = find(reader, game, 0);
+		if (!start(cursor, reader->index[first].offset) || !begin_game(cursor))
+			return 0;
+		if (entry->frame > 0){
+			if (!start(cursor, entry->offset))
+				return 0;
+			cursor->left = reader->parts ? UINT64_MAX : entry->bytes;
+			if (!next_segment(cursor, 1))
+				return 0;
+		}
+	} else if (reader->parts){
+		/* Otherwise, the game's first part is after the first part of the last game before it that is in the index, so the parts are read through from there, or from the very start. */
+		ptrdiff_t from = best >= 0 ? find(reader, reader->index[best].game, 0) : -1;
+		bool indexed = from >= 0 && reader->index[from].game == reader->index[best].game && reader->index[from].frame == 0;
+		if (!start(cursor, indexed ? reader->index[from].offset : 0) || !begin_game(cursor))
+			return 0;
+	} else {
+		/* Otherwise, read through from the last place before it that is in the index, or from the very start. */
+		uint64_t at = 0;
+		if (best >= 0){
+			const struct replay_index_entry * entry = &reader->index[best];
+			if (!start(cursor, entry->offset))
+				return 0;
+			if (entry->frame == 0){
+				if (!begin_game(cursor) || !skip_game(cursor))
+					return 0;
+			} else {
+				if (!pull(cursor, NULL, entry->bytes))
+					return 0;
+			}
+			at = entry->game + 1;
+		} else if (!start(cursor, 0)){
+			return 0;
+		}
+		for (; at < game; at++){
+			if (!begin_game(cursor) || !skip_game(cursor))
+				return 0;
+		}
+		if (!begin_game(cursor))
+			return 0;
+	}
+	while ((uint64_t)cursor->board.frames < frame && replay_step(cursor));
+	cursor->started = 1;
+	return 1;
+}
+
+/* Steps the board one frame along.  Returns 0 at the end of the game. */
+bool replay_step(struct replay_cursor * cursor)
+{
+	while (cursor->run == 0){
+		if (cursor->moves_left == 0){
+			if (cursor->left == 0 || !next_segment(cursor, 0))
+				return 0;
+			continue;
+		}
+		uint64_t value;
+		if (!read_varint(cursor, &value))
+			return 0;
+		cursor->direction = (value & 3) + 1;
+		cursor->run = value >> 2;
+	}
+	board_step(&cursor->board, cursor->direction);
+	cursor->run--;
+	return 1;
+}
+
+/* Moves on to the start of the next game in the file.  In a file in parts, that's from where it was passed, if it was; or if it couldn't have been, from wherever this game's got to; or failing both, from the index. */
+bool replay_next(struct replay_cursor * cursor)
+{
+	if (!cursor->reader->parts){
+		if (!skip_game(cursor) || !begin_game(cursor))
+			return 0;
+		cursor->game++;
+		return 1;
+	}
+	if (cursor->next_saved){
+		inflateEnd(&cursor->stream);
+		cursor->inflating = inflateCopy(&cursor->stream, &cursor->next_stream) == Z_OK;
+		forget_next(cursor);
+		if (!cursor->inflating)
+			return 0;
+		cursor->in_left = cursor->next_in_left;
+		memcpy(cursor->buffer, cursor->next_buffer, sizeof cursor->buffer);
+		cursor->at = cursor->next_at;
+		cursor->have = cursor->next_have;
+		take_part(cursor, &cursor->next_part);
+	} else if (cursor->in_order){
+		if (!pull(cursor, NULL, cursor->part_left))
+			return 0;
+		cursor->part_left = 0;
+		cursor->last_part = 0;
+	} else {
+		return replay_seek(cursor, cursor->reader, cursor->game + 1, 0);
+	}
+	cursor->game++;
+	cursor->moves_left = cursor->left = 0;
+	return begin_game(cursor);
+}
+
+void replay_done(struct replay_cursor * cursor)
+{
+	forget_next(cursor);
+	if (cursor->inflating)
+		inflateEnd(&cursor->stream);
+	board_free(&cursor->board);
+	cursor->inflating = 0;
+	cursor->started = 0;
+}
+
+/* Plays every game in the file back as fast as possible, and checks that each one ends the way it did when it was recorded. */
+bool run_playback(const char * filename)
+{
+	struct replay_reader reader;
+	if (!replay_map(&reader, filename)){
+		logmsg(lp_err, lc_misc, "Could not open the replay file %s.", filename);
+		return 0;
+	}
+	struct replay_cursor * cursor = calloc(1, sizeof *cursor);
+	if (cursor == NULL || !replay_seek(cursor, &reader, 0, 0)){
+		logmsg(lp_err, lc_misc, "%s doesn't have any games in it that can be played back.", filename);
+		free(cursor);
+		replay_unmap(&reader);
+		return 0;
+	}
+	logmsg(lp_info, lc_misc, "Playing back %s (%zu places in its index)…", filename, reader.entries);
+	uint64_t games = 0, mismatched = 0, frames = 0;
+	uint64_t start_ns = timing_now();
+	do {
+		while (replay_step(cursor));
+		frames += cursor->board.frames;
+		games++;
+		if ((uint64_t)cursor->board.frames != cursor->header.frames || cursor->board.score != cursor->header.score){
+			mismatched++;
+			logmsg(lp_warn, lc_misc, "Game %llu (seed %llu, played by %s) ended after %lld frames with a score of %u, but it was recorded as ending after %llu frames with a score of %u.", (unsigned long long)cursor->game, (unsigned long long)cursor->header.seed, cursor->name[0] != '\0' ? cursor->name : "a person", cursor->board.frames, cursor->board.score, (unsigned long long)cursor->header.frames, cursor->header.score);
+		}
+	} while (replay_next(cursor));
+	double secs = (timing_now() - start_ns) / 1e9;
+	logmsg(lp_info, lc_misc, "Played back %llu games (%llu frames) in %.3f seconds (%.0f frames per second); %llu didn't match their recordings.", (unsigned long long)games, (unsigned long long)frames, secs, secs > 0 ? frames / secs : 0.0, (unsigned long long)mismatched);
+	replay_done(cursor);
+	free(cursor);
+	replay_unmap(&reader);
+	return mismatched == 0;
+}
@@ -0,0 +1,81 @@
+/* LICENSE
+ *
+ * Copyright © 2021 Blue-Maned_Hawk.  All rights reserved.
+ *
+ * This software should have come with a file called LICENSE.  In case of any difference between this comment and that file, that file is the authority.  (If you did not recieve that file, it's a violation of the license.  Please report it to me.)
+ *
+ * This project is copylefted.  You may freely use, distribute, and modify this software, to the extent permitted by law, so long as you do not attempt to claim such activities are condoned by the author, you distribute the license file with any distributions of this software, you release any modifications under a similar license, and you do not attempt to claim that modified software is the original software.
+ *
+ * This license does not apply to software created with the API of this software (thought it does apply to the API itself); it also does not apply to any rule files, all of which must be placed in the public domain.
+ *
+ * This software links to zlib, which is under the zlib license, available at https://www.zlib.net/zlib_license.html.
+ *
+ * This software dynamically links to SDL2, which is under a separate instance of the zlib license, available at https://libsdl.org/license.php.
+ *
+ * This software dynamically links to libgcrypt, which is under the GNU LGPL2.1+, available at https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=COPYING;h=ccbbaf61b794c7aaea10dffb486095fdc8f3a44a;hb=HEAD.
+ *
+ * This license does not apply to trademarks or patents.
+ *
+ * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
+
+#ifndef PLAYBACK_H
+#define PLAYBACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "zlib.h"
+#include "Board.h"
+#include "Replay.h"
+
+/* A replay file, mapped into memory. */
+struct replay_reader {
+	const uint8_t * data;
+	size_t size;
+	size_t compressed; /* Where the gzip stream stops and the index starts. */
+	const struct replay_index_entry * index;
+	size_t entries;
+	bool parts; /* Whether the games are in parts, as they have been since version 3. */
+};
+
+/* Somewhere in a game in a replay file.  `board` is what the game looked like there. */
+struct replay_cursor {
+	const struct replay_reader * reader;
+	z_stream stream;
+	bool inflating;
+	size_t in_left; /* Compressed bytes that haven't been handed to zlib yet. */
+	uint8_t buffer[16384];
+	size_t at;
+	size_t have;
+	struct replay_header header;
+	char name[1024];
+	uint64_t game;
+	uint64_t left; /* Bytes of the game's segments after the current one. */
+	uint64_t moves_left; /* Bytes of moves left in the current segment. */
+	enum gake_direction direction;
+	uint64_t run;
+	struct board board;
+	bool started; /* Whether `replay_seek()` has put this somewhere yet. */
+	/* For files in parts. */
+	uint64_t part_left; /* Bytes of the game left in the part that's being read. */
+	bool last_part; /* Whether that part is the game's last. */
+	bool in_order; /* Whether every part since the game's first has been read, rather than jumped over, so that if the next game's first part isn't behind, it's ahead. */
+	/* Where the next game's first part was, if it was passed while this one was being read:  how far through the file inflation had got just after the part's header, and the header. */
+	bool next_saved;
+	z_stream next_stream;
+	size_t next_in_left;
+	uint8_t next_buffer[16384];
+	size_t next_at;
+	size_t next_have;
+	struct replay_part next_part;
+};
+
+extern bool replay_map(struct replay_reader * reader, const char * filename);
+extern void replay_unmap(struct replay_reader * reader);
+extern bool replay_seek(struct replay_cursor * cursor, const struct replay_reader * reader, uint64_t game, uint64_t frame);
+extern bool replay_step(struct replay_cursor * cursor);
+extern bool replay_next(struct replay_cursor * cursor);
+extern void replay_done(struct replay_cursor * cursor);
+extern bool run_playback(const char * filename);
+
+#endif/*ndef PLAYBACK_H*/
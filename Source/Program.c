@@ -0,0 +1,303 @@
+/* LICENSE
+ *
+ * Copyright © 2021 Blue-Maned_Hawk.  All rights reserved.
+ *
+ * This software should have come with a file called LICENSE.  In case of any difference between this comment and that file, that file is the authority.  (If you did not recieve that file, it's a violation of the license.  Please report it to me.)
+ *
+ * This project is copylefted.  You may freely use, distribute, and modify this software, to the extent permitted by law, so long as you do not attempt to claim such activities are condoned by the author, you distribute the license file with any distributions of this software, you release any modifications under a similar license, and you do not attempt to claim that modified software is the original software.
+ *
+ * This license does not apply to software created with the API of this software (thought it does apply to the API itself); it also does not apply to any rule files, all of which must be placed in the public domain.
+ *
+ * This software links to zlib, which is under the zlib license, available at https://www.zlib.net/zlib_license.html.
+ *
+ * This software dynamically links to SDL2, which is under a separate instance of the zlib license, available at https://libsdl.org/license.php.
+ *
+ * This software dynamically links to libgcrypt, which is under the GNU LGPL2.1+, available at https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=COPYING;h=ccbbaf61b794c7aaea10dffb486095fdc8f3a44a;hb=HEAD.
+ *
+ * This license does not apply to trademarks or patents.
+ *
+ * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
+
+/* This file runs the loaded programs in parallel.  Each program gets a worker thread and a board of its own, so a slow program only holds up itself, and the main thread only has to wait for all of them at the end of the frame—and not even then, if one of them takes longer than it's allowed to.
+ *
+ * When reading this file, you are expected to have access to and generally understand the following documents:
+ * 	· Latest draft of C2x:  http://www.open-std.org/JTC1/SC22/WG14/www/docs/n2596.pdf
+ * 	· The Clang compiler user(?) manual:  https://clang.llvm.org/docs/UsersManual.html
+ * 	· The latest POSIX specification:  https://pubs.opengroup.org/onlinepubs/9699919799/mindex.html */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "Program.h"
+#include "Board.h"
+#include "Isolate.h"
+#include "Logging.h"
+#include "Replay.h"
+#include "Timing.h"
+#include "Trace.h"
+#include <dlfcn.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+/* A program that's been over its budget this many times gets unloaded. */
+static const int max_strikes = 8;
+
+/* Opens a program's library, once, and looks up everything that the game might call.  Returns 0 if it can't be opened or doesn't have a `gake_main_v2()` or `gake_main()` in it. */
+bool program_open(struct program_code * code, const char * path)
+{
+	void * table = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+	if (table == NULL)
+		return 0;
+	*code = (struct program_code){
+		.table = table,
+		.main = dlsym(table, "gake_main_v2"),
+		.batch = dlsym(table, "gake_main_batch")
+	};
+	if (code->main == NULL)
+		code->main_v1 = dlsym(table, "gake_main");
+	if (code->main == NULL && code->main_v1 == NULL){
+		dlclose(table);
+		*code = (struct program_code){};
+		return 0;
+	}
+	const bool * deltas = dlsym(table, "gake_wants_deltas");
+	code->deltas = deltas != NULL && *deltas;
+	return 1;
+}
+
+void program_use(struct program * program, const struct program_code * code)
+{
+	program->table = code->table;
+	program->main = code->main;
+	program->main_v1 = code->main_v1;
+	program->batch = code->batch;
+	program->deltas = code->deltas;
+}
+
+static void * worker(void * arg)
+{
+	struct program * program = arg;
+	struct pool * pool = program->pool;
+	long long seen = 0;
+	trace_enter(program->trace);
+
+	for (;;){
+		pthread_mutex_lock(&pool->lock);
+		while (program->go == seen && !pool->stopping)
+			pthread_cond_wait(&pool->start, &pool->lock);
+		if (pool->stopping){
+			pthread_mutex_unlock(&pool->lock);
+			return NULL;
+		}
+		seen = program->go;
+		strcpy(program->keys, pool->keys);
+		pthread_mutex_unlock(&pool->lock);
+
+		uint64_t took = 0;
+		bool crashed = 0;
+		if (program->board.alive){
+			uint64_t started;
+			if (program->isolation.pid > 0){
+				started = timing_now();
+				crashed = !isolation_call(&program->isolation, &program->board, program->keys, &program->move);
+			} else {
+				board_describe(&program->board, &program->state, program->deltas);
+				started = timing_now();
+				program_call(program, &program->state, &program->move);
+			}
+			took = timing_now() - started;
+			histogram_record(&program->timing, took);
+			if (!crashed){
+				board_step(&program->board, program->move.direction);
+				replay_frame(&program->replay, &program->board);
+			}
+		}
+
+		pthread_mutex_lock(&pool->lock);
+		program->busy = 0;
+		program->last_ns = took;
+		program->crashed |= crashed;
+		pthread_cond_signal(&pool->finished);
+		pthread_mutex_unlock(&pool->lock);
+	}
+}
+
+bool pool_start(struct pool * pool, struct program * programs, short count, uint64_t budget_ns)
+{
+	*pool = (struct pool){
+		.programs = programs,
+		.count = count,
+		.budget_ns = budget_ns
+	};
+	pthread_condattr_t attr;
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC); /* So that the deadline can come from `timing_now()`. */
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->start, NULL);
+	pthread_cond_init(&pool->finished, &attr);
+	pthread_condattr_destroy(&attr);
+	for (register short i = 0; i < count; i++){
+		programs[i].pool = pool;
+		programs[i].state.keys = programs[i].keys;
+		if (pthread_create(&programs[i].thread, NULL, worker, &programs[i]) != 0){
+			pool->count = i;
+			pool_stop(pool);
+			return 0;
+		}
+	}
+	return 1;
+}
+
+enum strike {
+	strike_late, /* It finished its turn, but not in time. */
+	strike_unfinished, /* It hadn't finished its turn by the end of the frame. */
+	strike_stuck /* It still hasn't finished a turn from an earlier frame, and another budget's worth of time has gone by. */
+};
+
+/* Must be called with the lock held. */
+static void strike(struct pool * pool, struct program * program, enum strike why)
+{
+	program->strikes++;
+	program->struck_ns = timing_now();
+	switch (why){
+	case strike_late:
+		logmsg(lp_warn, lc_apiprgm, "Program %s took %.3f ms, which is over its budget of %.3f ms.", program->name, program->last_ns / 1e6, pool->budget_ns / 1e6);
+		break;
+	case strike_unfinished:
+		logmsg(lp_warn, lc_apiprgm, "Program %s didn't finish within its budget of %.3f ms.", program->name, pool->budget_ns / 1e6);
+		break;
+	case strike_stuck:
+		logmsg(lp_warn, lc_apiprgm, "Program %s still hasn't finished the turn it started on frame %lld.", program->name, program->turn);
+		break;
+	}
+	if (program->strikes >= max_strikes){
+		program->unloaded = 1;
+		isolation_kill(&program->isolation);
+		logmsg(lp_err, lc_apiprgm, "Program %s has gone over its budget %d times, so it has been unloaded.", program->name, program->strikes);
+	} else {
+		long long skip = 1LL << (program->strikes < 6 ? program->strikes : 6);
+		program->skip_until = pool->frame + skip;
+		if (why != strike_stuck)
+			logmsg(lp_note, lc_apiprgm, "Program %s will be skipped for the next %lld frames.", program->name, skip);
+	}
+}
+
+/* Programs that are skipped, unloaded, or still busy from an earlier frame don't get a turn, and their boards don't move.  Returns how long was spent waiting for the programs, which is never more than their budget. */
+uint64_t pool_run_frame(struct pool * pool, const char * keys)
+{
+	bool dispatched[8] = {};
+	if (pool->count <= 0)
+		return 0;
+	pthread_mutex_lock(&pool->lock);
+	strcpy(pool->keys, keys);
+	pool->frame++;
+	for (register short i = 0; i < pool->count; i++){
+		struct program * program = &pool->programs[i];
+		if (program->unloaded || program->busy || pool->frame < program->skip_until)
+			continue;
+		program->busy = 1;
+		program->turn = pool->frame;
+		program->go++;
+		dispatched[i] = 1;
+	}
+	pthread_cond_broadcast(&pool->start);
+
+	uint64_t waiting_since = timing_now();
+	uint64_t deadline = waiting_since + pool->budget_ns;
+	struct timespec until = { deadline / 1000000000, deadline % 1000000000 };
+	for (;;){
+		bool waiting = 0;
+		for (register short i = 0; i < pool->count; i++)
+			waiting |= dispatched[i] && pool->programs[i].busy;
+		if (!waiting || pthread_cond_timedwait(&pool->finished, &pool->lock, &until) == ETIMEDOUT)
+			break;
+	}
+	uint64_t waited = timing_now() - waiting_since;
+
+	for (register short i = 0; i < pool->count; i++){
+		struct program * program = &pool->programs[i];
+		if (program->crashed && !program->unloaded){
+			program->unloaded = 1;
+			if (program->isolation.signal != 0)
+				logmsg(lp_err, lc_apiprgm, "Program %s crashed (%s), so it has been unloaded.", program->name, strsignal(program->isolation.signal));
+			else
+				logmsg(lp_err, lc_apiprgm, "Program %s exited on its own, so it has been unloaded.", program->name);
+			continue;
+		}
+		if (program->unloaded)
+			continue;
+		/* A program that's hung for good would otherwise only ever be counted against once, since it never gets another turn, so it keeps being counted against for as long as it's stuck, and is unloaded in the end like any other. */
+		if (!dispatched[i]){
+			if (program->busy && timing_now() - program->struck_ns >= pool->budget_ns)
+				strike(pool, program, strike_stuck);
+			continue;
+		}
+		if (program->busy)
+			strike(pool, program, strike_unfinished);
+		else if (program->last_ns > pool->budget_ns)
+			strike(pool, program, strike_late);
+	}
+	pthread_mutex_unlock(&pool->lock);
+	return waited < pool->budget_ns ? waited : pool->budget_ns;
+}
+
+bool pool_busy(struct pool * pool, short index)
+{
+	if (index >= pool->count)
+		return 0;
+	pthread_mutex_lock(&pool->lock);
+	bool busy = pool->programs[index].busy;
+	pthread_mutex_unlock(&pool->lock);
+	return busy;
+}
+
+/* Swaps a rebuilt version of a program in between turns, keeping its board, and gives it a clean slate:  a program that had been unloaded for going over its budget gets another go.  Returns 0, changing nothing, if the program is still in the middle of a turn; otherwise, `*old_table` is the library that was swapped out, for the caller to close. */
+bool pool_replace(struct pool * pool, short index, const struct program_code * code, void ** old_table)
+{
+	struct program * program = &pool->programs[index];
+	pthread_mutex_lock(&pool->lock);
+	bool busy = program->busy;
+	if (!busy){
+		*old_table = program->table;
+		program_use(program, code);
+		program->strikes = 0;
+		program->skip_until = 0;
+		program->unloaded = 0;
+	}
+	pthread_mutex_unlock(&pool->lock);
+	return !busy;
+}
+
+/* This is safe to call more than once.  A program that's still stuck in its turn can't be waited for, so its thread is just left to die with the process (and it must not be `dlclose()`d)—unless the program is isolated, in which case its process is killed and its thread can be waited for after all. */
+void pool_stop(struct pool * pool)
+{
+	if (pool->programs == NULL)
+		return;
+	pthread_mutex_lock(&pool->lock);
+	pool->stopping = 1;
+	pthread_cond_broadcast(&pool->start);
+	bool stuck[8] = {};
+	for (register short i = 0; i < pool->count; i++){
+		stuck[i] = pool->programs[i].busy;
+		if (stuck[i] && pool->programs[i].isolation.pid > 0){
+			isolation_kill(&pool->programs[i].isolation); /* Its worker will notice and finish up. */
+			stuck[i] = 0;
+		}
+	}
+	pthread_mutex_unlock(&pool->lock);
+	for (register short i = 0; i < pool->count; i++){
+		if (stuck[i])
+			pthread_detach(pool->programs[i].thread);
+		else
+			pthread_join(pool->programs[i].thread, NULL);
+	}
+	if (memchr(stuck, 1, sizeof stuck) != NULL)
+		return; /* The lock and conditions might still be used by the stuck threads. */
+	pthread_mutex_destroy(&pool->lock);
+	pthread_cond_destroy(&pool->start);
+	pthread_cond_destroy(&pool->finished);
+	*pool = (struct pool){};
+}
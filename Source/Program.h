@@ -0,0 +1,136 @@
+/* LICENSE
+ *
+ * Copyright © 2021 Blue-Maned_Hawk.  All rights reserved.
+ *
+ * This software should have come with a file called LICENSE.  In case of any difference between this comment and that file, that file is the authority.  (If you did not recieve that file, it's a violation of the license.  Please report it to me.)
+ *
+ * This project is copylefted.  You may freely use, distribute, and modify this software, to the extent permitted by law, so long as you do not attempt to claim such activities are condoned by the author, you distribute the license file with any distributions of this software, you release any modifications under a similar license, and you do not attempt to claim that modified software is the original software.
+ *
+ * This license does not apply to software created with the API of this software (thought it does apply to the API itself); it also does not apply to any rule files, all of which must be placed in the public domain.
+ *
+ * This software links to zlib, which is under the zlib license, available at https://www.zlib.net/zlib_license.html.
+ *
+ * This software dynamically links to SDL2, which is under a separate instance of the zlib license, available at https://libsdl.org/license.php.
+ *
+ * This software dynamically links to libgcrypt, which is under the GNU LGPL2.1+, available at https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=COPYING;h=ccbbaf61b794c7aaea10dffb486095fdc8f3a44a;hb=HEAD.
+ *
+ * This license does not apply to trademarks or patents.
+ *
+ * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
+
+#ifndef PROGRAM_H
+#define PROGRAM_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "Board.h"
+#include "Isolate.h"
+#include "Replay.h"
+#include "Timing.h"
+#include "Trace.h"
+#include "../gake.h"
+
+typedef void (* program_main)(const struct gake_curstate * state, struct gake_newstate * move);
+/* The state exactly as the `gake.h` from before `gake_main_v2()` laid it out, which is what programs that only have `gake_main()` were built to take.  That header ended with the keys as a flexible array member, which isn't part of a copy, so they were never passed, and aren't here. */
+struct gake_curstate_v1 {
+	long long frame;
+	int width;
+	int height;
+	int head_x;
+	int head_y;
+	int apple_x;
+	int apple_y;
+	unsigned length;
+	enum gake_direction direction;
+	_Bool alive;
+};
+
+typedef struct gake_newstate (* program_main_v1)(struct gake_curstate_v1 state);
+typedef void (* batch_main)(const struct gake_curstate * states, struct gake_newstate * moves, size_t count);
+
+struct pool;
+
+/* What's looked up in a program's library when it's opened. */
+struct program_code {
+	void * table;
+	program_main main;
+	program_main_v1 main_v1;
+	batch_main batch;
+	bool deltas;
+};
+
+/* Everything about one loaded API-using program.  Each one plays on its own board. */
+struct program {
+	struct pool * pool;
+	char name[1024];
+	void * table;
+	program_main main;
+	program_main_v1 main_v1; /* Only for programs built against an older `gake.h`, which don't have `main`; see `program_call()`. */
+	batch_main batch;
+	bool deltas; /* Whether the program wants to be told what changed each frame. */
+	struct board board;
+	struct gake_curstate state;
+	struct gake_newstate move;
+	char keys[64]; /* What `state.keys` points to. */
+	pthread_t thread;
+	struct histogram timing; /* How long each call to `main` took.  Only touched by the program's own worker. */
+	struct replay replay; /* Only touched by the program's own worker while it's busy. */
+	struct isolation isolation; /* Only used when the program runs in a process of its own; see `Source/Isolate.c`. */
+	struct trace * trace; /* What the program has logged with `gake_log()`; kept when the program is reloaded. */
+	/* Everything from here down is protected by the pool's lock. */
+	long long go; /* Bumped by the main thread to give the program a turn. */
+	bool busy;
+	long long turn; /* The frame that its last turn started on. */
+	uint64_t struck_ns; /* When it was last counted as going over its budget. */
+	uint64_t last_ns;
+	int strikes;
+	long long skip_until;
+	bool unloaded;
+	bool crashed; /* Only ever set for isolated programs. */
+};
+
+/* The workers that run the programs, one thread each.  The main thread starts a frame with `pool_run_frame()`, and that returns once every program has had its turn or the budget for the frame has run out, whichever comes first.  A program that goes over its budget is skipped for a while, for longer each time it happens, and is unloaded if it keeps happening; the other programs carry on regardless. */
+struct pool {
+	struct program * programs;
+	short count;
+	uint64_t budget_ns;
+	pthread_mutex_t lock;
+	pthread_cond_t start;
+	pthread_cond_t finished;
+	long long frame;
+	bool stopping;
+	char keys[64];
+};
+
+/* The shim for programs built against an older `gake.h`:  those get a copy of the state, in the old layout, instead of a pointer to it. */
+static inline void program_call(const struct program * program, const struct gake_curstate * state, struct gake_newstate * move)
+{
+	if (program->main != NULL){
+		program->main(state, move);
+		return;
+	}
+	*move = program->main_v1((struct gake_curstate_v1){
+		.frame = state->frame,
+		.width = state->width,
+		.height = state->height,
+		.head_x = state->head_x,
+		.head_y = state->head_y,
+		.apple_x = state->apple_x,
+		.apple_y = state->apple_y,
+		.length = state->length,
+		.direction = state->direction,
+		.alive = state->alive
+	});
+}
+
+extern bool program_open(struct program_code * code, const char * path);
+extern void program_use(struct program * program, const struct program_code * code);
+extern bool pool_start(struct pool * pool, struct program * programs, short count, uint64_t budget_ns);
+extern bool pool_busy(struct pool * pool, short index);
+extern uint64_t pool_run_frame(struct pool * pool, const char * keys);
+extern bool pool_replace(struct pool * pool, short index, const struct program_code * code, void ** old_table);
+extern void pool_stop(struct pool * pool);
+
+#endif/*ndef PROGRAM_H*/
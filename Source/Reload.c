@@ -0,0 +1,170 @@
+/* LICENSE
+ *
+ * Copyright © 2021 Blue-Maned_Hawk.  All rights reserved.
+ *
+ * This software should have come with a file called LICENSE.  In case of any difference between this comment and that file, that file is the authority.  (If you did not recieve that file, it's a violation of the license.  Please report it to me.)
+ *
+ * This project is copylefted.  You may freely use, distribute, and modify this software, to the extent permitted by law, so long as you do not attempt to claim such activities are condoned by the author, you distribute the license file with any distributions of this software, you release any modifications under a similar license, and you do not attempt to claim that modified software is the original software.
+ *
+ * This license does not apply to software created with the API of this software (thought it does apply to the API itself); it also does not apply to any rule files, all of which must be placed in the public domain.
+ *
+ * This software links to zlib, which is under the zlib license, available at https://www.zlib.net/zlib_license.html.
+ *
+ * This software dynamically links to SDL2, which is under a separate instance of the zlib license, available at https://libsdl.org/license.php.
+ *
+ * This software dynamically links to libgcrypt, which is under the GNU LGPL2.1+, available at https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=COPYING;h=ccbbaf61b794c7aaea10dffb486095fdc8f3a44a;hb=HEAD.
+ *
+ * This license does not apply to trademarks or patents.
+ *
+ * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
+
+/* This file reloads programs when they're rebuilt, so that working on one doesn't mean restarting Gake over and over.  The directory each one is in is watched with inotify (the file itself can't be, since a lot of linkers write a new file and rename it over the old one), and between frames, any program that's changed is opened again and swapped in, carrying on with the board it had.
+ *
+ * The new version is copied somewhere else before it's opened.  `dlopen()` hands back the library that's already open if it's given the same file again, so opening the rebuilt one where it is would just get the old one back; and this way, a version that won't open leaves the old one running.
+ *
+ * When reading this file, you are expected to have access to and generally understand the following documents:
+ * 	· Latest draft of C2x:  http://www.open-std.org/JTC1/SC22/WG14/www/docs/n2596.pdf
+ * 	· The Clang compiler user(?) manual:  https://clang.llvm.org/docs/UsersManual.html
+ * 	· The latest POSIX specification:  https://pubs.opengroup.org/onlinepubs/9699919799/mindex.html
+ * 	· The Linux manpages, for inotify:  https://man7.org/linux/man-pages/man7/inotify.7.html */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "Reload.h"
+#include "Logging.h"
+#include "Program.h"
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+static const char * base_name(const char * path)
+{
+	const char * slash = strrchr(path, '/');
+	return slash != NULL ? slash + 1 : path;
+}
+
+bool reload_start(struct reload * reload, const struct program * programs, short count)
+{
+	*reload = (struct reload){ .fd = -1 };
+	if (count <= 0)
+		return 0;
+	reload->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (reload->fd < 0)
+		return 0;
+	for (register short i = 0; i < count; i++){
+		char directory[PATH_MAX] = ".";
+		const char * slash = strrchr(programs[i].name, '/');
+		if (slash != NULL && (size_t)(slash - programs[i].name) < sizeof directory){
+			memcpy(directory, programs[i].name, slash - programs[i].name);
+			directory[slash - programs[i].name] = '\0';
+			if (slash == programs[i].name)
+				strcpy(directory, "/");
+		}
+		reload->watches[i] = inotify_add_watch(reload->fd, directory, IN_CLOSE_WRITE | IN_MOVED_TO);
+		if (reload->watches[i] < 0)
+			logmsg(lp_warn, lc_api, "Can't watch %s for changes, so program %s won't be reloaded when it's rebuilt.", directory, programs[i].name);
+	}
+	return 1;
+}
+
+/* Copies the library at `from` into a new file, whose name is put in `to`. */
+static bool copy_library(const char * from, char * to, size_t size)
+{
+	const char * directory = getenv("TMPDIR");
+	if (directory == NULL || directory[0] == '\0')
+		directory = "/tmp";
+	if (snprintf(to, size, "%s/gake-reload-XXXXXX", directory) >= (int)size)
+		return 0;
+	int out = mkstemp(to);
+	if (out < 0)
+		return 0;
+	int in = open(from, O_RDONLY);
+	bool copied = in >= 0;
+	char buffer[65536];
+	while (copied){
+		ssize_t got = read(in, buffer, sizeof buffer);
+		if (got == 0)
+			break;
+		if (got < 0){
+			copied = errno == EINTR;
+			continue;
+		}
+		for (ssize_t put = 0; put < got && copied;){
+			ssize_t wrote = write(out, buffer + put, got - put);
+			if (wrote >= 0)
+				put += wrote;
+			else
+				copied = errno == EINTR;
+		}
+	}
+	if (in >= 0)
+		close(in);
+	if (close(out) != 0)
+		copied = 0;
+	if (!copied)
+		unlink(to);
+	return copied;
+}
+
+/* Call between frames.  A program whose worker is still busy with an earlier frame is left until a later one. */
+void reload_poll(struct reload * reload, struct pool * pool, struct program * programs, short count)
+{
+	if (reload->fd < 0 || pool->programs == NULL)
+		return;
+	_Alignas(struct inotify_event) char events[4096];
+	ssize_t got;
+	while ((got = read(reload->fd, events, sizeof events)) > 0){
+		for (char * at = events; at < events + got;){
+			const struct inotify_event * event = (const struct inotify_event *)at;
+			at += sizeof *event + event->len;
+			for (register short i = 0; event->len > 0 && i < count; i++){
+				if (event->wd == reload->watches[i] && strcmp(event->name, base_name(programs[i].name)) == 0)
+					reload->pending[i] = 1;
+			}
+		}
+	}
+
+	for (register short i = 0; i < count; i++){
+		if (!reload->pending[i] || pool_busy(pool, i))
+			continue;
+		reload->pending[i] = 0;
+		if (programs[i].isolation.pid > 0){
+			logmsg(lp_note, lc_api, "Program %s has been rebuilt, but it's running in a process of its own, so Gake has to be restarted to use the new version.", programs[i].name);
+			continue;
+		}
+		char copy[PATH_MAX];
+		struct program_code code;
+		if (!copy_library(programs[i].name, copy, sizeof copy)){
+			logmsg(lp_err, lc_api, "Program %s has been rebuilt, but the new version couldn't be copied (%s); the old one will keep running.", programs[i].name, strerror(errno));
+			continue;
+		}
+		bool opened = program_open(&code, copy);
+		unlink(copy); /* It stays mapped for as long as it's open. */
+		if (!opened){
+			logmsg(lp_err, lc_api, "Program %s has been rebuilt, but the new version couldn't be loaded; the old one will keep running.", programs[i].name);
+			continue;
+		}
+		void * old;
+		if (!pool_replace(pool, i, &code, &old)){
+			dlclose(code.table);
+			reload->pending[i] = 1;
+			continue;
+		}
+		dlclose(old);
+		logmsg(lp_info, lc_api, "Program %s has been rebuilt and reloaded; it's carrying on from frame %lld of its game.", programs[i].name, programs[i].board.frames);
+	}
+}
+
+void reload_stop(struct reload * reload)
+{
+	if (reload->fd >= 0)
+		close(reload->fd);
+	*reload = (struct reload){ .fd = -1 };
+}
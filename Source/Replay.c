@@ -0,0 +1,312 @@
+/* LICENSE
+ *
+ * Copyright © 2021 Blue-Maned_Hawk.  All rights reserved.
+ *
+ * This software should have come with a file called LICENSE.  In case of any difference between this comment and that file, that file is the authority.  (If you did not recieve that file, it's a violation of the license.  Please report it to me.)
+ *
+ * This project is copylefted.  You may freely use, distribute, and modify this software, to the extent permitted by law, so long as you do not attempt to claim such activities are condoned by the author, you distribute the license file with any distributions of this software, you release any modifications under a similar license, and you do not attempt to claim that modified software is the original software.
+ *
+ * This license does not apply to software created with the API of this software (thought it does apply to the API itself); it also does not apply to any rule files, all of which must be placed in the public domain.
+ *
+ * This software links to zlib, which is under the zlib license, available at https://www.zlib.net/zlib_license.html.
+ *
+ * This software dynamically links to SDL2, which is under a separate instance of the zlib license, available at https://libsdl.org/license.php.
+ *
+ * This software dynamically links to libgcrypt, which is under the GNU LGPL2.1+, available at https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=COPYING;h=ccbbaf61b794c7aaea10dffb486095fdc8f3a44a;hb=HEAD.
+ *
+ * This license does not apply to trademarks or patents.
+ *
+ * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
+
+/* This file records games so that they can be played back later.  Only the direction the snake went in each frame needs to be kept, since everything else follows from the seed, and the snake mostly goes straight, so each run of frames in one direction gets squeezed down into a varint of a byte or two.  Every so often, the whole board is saved as a keyframe, so that playback can start from the middle of a game without going through all of it.  Everything up to a keyframe is written through zlib as soon as the keyframe is reached, as a part of the game, and the rest when the game's over, so only the moves since the last keyframe are ever kept in memory, and a game that never gets to end (because the game crashed, say) still has everything up to its last keyframe in the file.  Before each part of a game that has keyframes, the compressor is fully flushed, and where that happened goes in an index at the end of the file.
+ *
+ * When reading this file, you are expected to have access to and generally understand the following documents:
+ * 	· Latest draft of C2x:  http://www.open-std.org/JTC1/SC22/WG14/www/docs/n2596.pdf
+ * 	· The Clang compiler user(?) manual:  https://clang.llvm.org/docs/UsersManual.html
+ * 	· The latest POSIX specification:  https://pubs.opengroup.org/onlinepubs/9699919799/mindex.html
+ * 	· The zlib manual:  https://zlib.net/manual.html */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "Replay.h"
+#include "Board.h"
+#include "Logging.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "zlib.h"
+
+/* Makes room for `more` bytes at the end of the game.  If there isn't enough memory, the game stops being recorded and won't be written out. */
+static bool reserve(struct replay * replay, size_t more)
+{
+	size_t needed = replay->used + more;
+	if (needed <= replay->allocated)
+		return 1;
+	size_t allocated = replay->allocated ? replay->allocated : 256;
+	while (allocated < needed)
+		allocated *= 2;
+	uint8_t * data = realloc(replay->data, allocated);
+	if (data == NULL){
+		replay->broken = 1;
+		replay->recording = 0;
+		return 0;
+	}
+	replay->data = data;
+	replay->allocated = allocated;
+	return 1;
+}
+
+/* Adds the run that's been building up to the moves.  This is the slow path of `replay_frame()`, and only happens when the snake turns. */
+void replay_run(struct replay * replay)
+{
+	if (!reserve(replay, 10)) /* A varint of 64 bits is at most 10 bytes. */
+		return;
+	uint64_t value = replay->run << 2 | (replay->direction - 1);
+	while (value >= 0x80){
+		replay->data[replay->used++] = value | 0x80;
+		value >>= 7;
+	}
+	replay->data[replay->used++] = value;
+	replay->run = 0;
+}
+
+/* The segment's header is written when it's started, but how many bytes of moves it has isn't known until it's finished. */
+static void finish_segment(struct replay * replay)
+{
+	struct replay_segment segment;
+	memcpy(&segment, replay->data + replay->segment, sizeof segment);
+	segment.moves_bytes = replay->used - replay->segment - sizeof segment - segment.state_bytes;
+	memcpy(replay->data + replay->segment, &segment, sizeof segment);
+}
+
+/* The first segment has no keyframe, so `board` is NULL for that. */
+static void start_segment(struct replay * replay, const struct board * board)
+{
+	size_t state_bytes = board != NULL ? board_image_size(board) : 0;
+	if (!reserve(replay, sizeof (struct replay_segment) + state_bytes))
+		return;
+	struct replay_segment segment = {
+		.frame = replay->header.frames,
+		.state_bytes = state_bytes
+	};
+	replay->segment = replay->used;
+	memcpy(replay->data + replay->used, &segment, sizeof segment);
+	replay->used += sizeof segment;
+	if (board != NULL)
+		board_save(board, replay->data + replay->used);
+	replay->used += state_bytes;
+}
+
+static bool write_part(struct replay * replay, uint64_t frames, uint32_t score, bool last);
+
+/* Called by `replay_frame()` every `REPLAY_KEYFRAME_INTERVAL` frames.  Everything up to here is written out before the keyframe is started. */
+void replay_keyframe(struct replay * replay, const struct board * board)
+{
+	if (replay->run > 0)
+		replay_run(replay);
+	if (!replay->recording)
+		return;
+	finish_segment(replay);
+	pthread_mutex_lock(&replay->file->lock);
+	bool written = write_part(replay, replay->header.frames, board->score, 0);
+	pthread_mutex_unlock(&replay->file->lock);
+	if (!written){
+		replay->broken = 1;
+		replay->recording = 0;
+		return;
+	}
+	start_segment(replay, board);
+	replay->next_keyframe += REPLAY_KEYFRAME_INTERVAL;
+}
+
+/* Starts recording the game on `board`, which should have just been set up with `board_init()`, to `file`.  Whatever was recorded before is thrown away, but the memory for it is kept. */
+void replay_begin(struct replay_file * file, struct replay * replay, const struct board * board, uint64_t seed, const char * name)
+{
+	uint8_t * data = replay->data;
+	size_t allocated = replay->allocated;
+	*replay = (struct replay){
+		.header = {
+			.magic = "GAKERPL",
+			.version = 3,
+			.rules = board->topology,
+			.width = board->width,
+			.height = board->height,
+			.seed = seed,
+			.name_length = name != NULL ? strlen(name) : 0
+		},
+		.name = name,
+		.file = file,
+		.data = data,
+		.allocated = allocated,
+		.next_keyframe = REPLAY_KEYFRAME_INTERVAL,
+		.direction = board->direction,
+		.game = UINT64_MAX,
+		.first_entry = SIZE_MAX,
+		.recording = 1
+	};
+	start_segment(replay, NULL);
+}
+
+void replay_free(struct replay * replay)
+{
+	free(replay->data);
+	*replay = (struct replay){};
+}
+
+bool replay_open(struct replay_file * file, const char * filename)
+{
+	*file = (struct replay_file){
+		.file = gzopen(filename, "wb6"),
+		.filename = strdup(filename)
+	};
+	if (file->file == NULL || file->filename == NULL){
+		logmsg(lp_err, lc_misc, "Could not open %s to record replays to.", filename);
+		if (file->file != NULL)
+			gzclose(file->file);
+		free(file->filename);
+		*file = (struct replay_file){};
+		return 0;
+	}
+	if (gzwrite(file->file, REPLAY_PARTS_MAGIC, sizeof REPLAY_PARTS_MAGIC) != (int)sizeof REPLAY_PARTS_MAGIC){
+		logmsg(lp_err, lc_misc, "Could not write to %s to record replays to.", filename);
+		gzclose(file->file);
+		free(file->filename);
+		*file = (struct replay_file){};
+		return 0;
+	}
+	pthread_mutex_init(&file->lock, NULL);
+	return 1;
+}
+
+/* Must be called with the lock held.  Flushes the compressor, so that inflation can start from here, and notes where here is.  How much of the game is left from here is filled in when it's over. */
+static bool mark(struct replay_file * file, struct replay * replay, uint64_t frame)
+{
+	if (file->entries == file->allocated){
+		size_t allocated = file->allocated ? file->allocated * 2 : 64;
+		struct replay_index_entry * index = realloc(file->index, allocated * sizeof *index);
+		if (index == NULL)
+			return 0;
+		file->index = index;
+		file->allocated = allocated;
+	}
+	if (gzflush(file->file, Z_FULL_FLUSH) != Z_OK)
+		return 0;
+	if (replay->first_entry == SIZE_MAX)
+		replay->first_entry = file->entries;
+	file->index[file->entries++] = (struct replay_index_entry){
+		.game = replay->game,
+		.frame = frame,
+		.offset = gzoffset(file->file),
+		.bytes = UINT64_MAX
+	};
+	return 1;
+}
+
+/* Must be called with the lock held.  Writes out everything that's been recorded since the last part (which is whole segments, since the last one has been finished) as a part of its own, with the header in front if it's the first.  A game gets its number when its first part is written, so that the numbers go in the same order as the first parts do.  Every part of a game that has keyframes is marked in the index, and flushed out to the file once it's been written, so that it's there even if the game never gets to its end. */
+static bool write_part(struct replay * replay, uint64_t frames, uint32_t score, bool last)
+{
+	struct replay_file * file = replay->file;
+	bool first = replay->game == UINT64_MAX;
+	if (first)
+		replay->game = file->games++;
+	struct replay_segment segment = {};
+	if (replay->used >= sizeof segment)
+		memcpy(&segment, replay->data, sizeof segment);
+	bool indexed = replay->first_entry != SIZE_MAX || (first && !last);
+	struct replay_part part = {
+		.game = replay->game,
+		.frames = frames,
+		.score = score,
+		.last = last,
+		.bytes = (first ? sizeof replay->header + replay->header.name_length : 0) + replay->used
+	};
+	if (first){
+		replay->header.frames = frames;
+		replay->header.score = score;
+	}
+	bool written = (!indexed || replay->used == 0 || mark(file, replay, segment.frame))
+		&& gzwrite(file->file, &part, sizeof part) == (int)sizeof part
+		&& (!first || gzwrite(file->file, &replay->header, sizeof replay->header) == (int)sizeof replay->header)
+		&& (!first || gzwrite(file->file, replay->name, replay->header.name_length) == (int)replay->header.name_length)
+		&& gzwrite(file->file, replay->data, replay->used) == (int)replay->used
+		&& (!indexed || last || gzflush(file->file, Z_SYNC_FLUSH) == Z_OK);
+	if (!written){
+		/* The number goes to the next game instead, so that there's no gap.  (If any of the part did get written, the file's broken anyway.) */
+		if (first){
+			replay->game = UINT64_MAX;
+			file->games--;
+		}
+		return 0;
+	}
+	replay->used = 0;
+	replay->parted_frames = frames;
+	replay->parted_score = score;
+	for (register size_t i = replay->first_entry; last && i < file->entries; i++){
+		if (file->index[i].game == replay->game)
+			file->index[i].bytes = frames - file->index[i].frame;
+	}
+	return 1;
+}
+
+/* Finishes recording the game and writes the rest of it out.  Nothing is written if nothing was being recorded.  A game that couldn't all be written is still ended, if any of it was, where its last part left off. */
+bool replay_write(struct replay * replay, const struct board * board)
+{
+	if (replay->file == NULL || !(replay->recording || replay->broken))
+		return 0;
+	if (replay->run > 0)
+		replay_run(replay);
+	if (replay->recording)
+		finish_segment(replay);
+	replay->recording = 0;
+
+	struct replay_file * file = replay->file;
+	pthread_mutex_lock(&file->lock);
+	bool written = !replay->broken && write_part(replay, replay->header.frames, board->score, 1);
+	if (!written && replay->game != UINT64_MAX){
+		replay->used = 0;
+		write_part(replay, replay->parted_frames, replay->parted_score, 1);
+	}
+	file->lost += !written;
+	pthread_mutex_unlock(&file->lock);
+	replay->broken = 0;
+	return written;
+}
+
+static int by_game_and_frame(const void * a, const void * b)
+{
+	const struct replay_index_entry * left = a, * right = b;
+	if (left->game != right->game)
+		return left->game < right->game ? -1 : 1;
+	return (left->frame > right->frame) - (left->frame < right->frame);
+}
+
+/* The index goes after the end of the gzip stream, where gzip ignores it. */
+void replay_close(struct replay_file * file)
+{
+	if (file->file == NULL)
+		return;
+	gzclose(file->file);
+	/* The entries went in as the parts were written, which isn't always in order of the games' numbers. */
+	qsort(file->index, file->entries, sizeof *file->index, by_game_and_frame);
+	if (file->entries > 0){
+		FILE * out = fopen(file->filename, "ab");
+		struct replay_index_tail tail = {
+			.entries = file->entries,
+			.magic = "GAKEIDX"
+		};
+		if (out == NULL || fwrite(file->index, sizeof *file->index, file->entries, out) != file->entries || fwrite(&tail, sizeof tail, 1, out) != 1)
+			logmsg(lp_warn, lc_misc, "The index of %s couldn't be written, so it'll be slow to seek through.", file->filename);
+		if (out != NULL)
+			fclose(out);
+	}
+	pthread_mutex_destroy(&file->lock);
+	logmsg(lp_info, lc_misc, "%llu games have been recorded.", (unsigned long long)file->games);
+	if (file->lost > 0)
+		logmsg(lp_warn, lc_misc, "%llu games couldn't be recorded, or only partly, since there wasn't enough memory or disk space for them.", (unsigned long long)file->lost);
+	free(file->index);
+	free(file->filename);
+	*file = (struct replay_file){};
+}
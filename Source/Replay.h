@@ -0,0 +1,136 @@
+/* LICENSE
+ *
+ * Copyright © 2021 Blue-Maned_Hawk.  All rights reserved.
+ *
+ * This software should have come with a file called LICENSE.  In case of any difference between this comment and that file, that file is the authority.  (If you did not recieve that file, it's a violation of the license.  Please report it to me.)
+ *
+ * This project is copylefted.  You may freely use, distribute, and modify this software, to the extent permitted by law, so long as you do not attempt to claim such activities are condoned by the author, you distribute the license file with any distributions of this software, you release any modifications under a similar license, and you do not attempt to claim that modified software is the original software.
+ *
+ * This license does not apply to software created with the API of this software (thought it does apply to the API itself); it also does not apply to any rule files, all of which must be placed in the public domain.
+ *
+ * This software links to zlib, which is under the zlib license, available at https://www.zlib.net/zlib_license.html.
+ *
+ * This software dynamically links to SDL2, which is under a separate instance of the zlib license, available at https://libsdl.org/license.php.
+ *
+ * This software dynamically links to libgcrypt, which is under the GNU LGPL2.1+, available at https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=COPYING;h=ccbbaf61b794c7aaea10dffb486095fdc8f3a44a;hb=HEAD.
+ *
+ * This license does not apply to trademarks or patents.
+ *
+ * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "zlib.h"
+#include "Board.h"
+#include "../gake.h"
+
+/* A replay file is a gzipped stream of parts of games (see below), optionally followed by an index.  Each game is this header, then `name_length` bytes of the name of the program that played it (none for a person), then its segments.  Since the board is seeded, replaying the moves from the seed gives back the whole game; the keyframes are only there so that nobody has to.  (Before version 3, there were no parts:  the games were one after another, whole, and `bytes` was how many bytes of segments there were.  Since then, it's 0.) */
+struct replay_header {
+	char magic[8]; /* "GAKERPL" */
+	uint32_t version;
+	uint32_t rules; /* The `enum gake_topology` that the game was played on; 0, for a plane, is plain Snake. */
+	int32_t width;
+	int32_t height;
+	uint64_t seed;
+	uint64_t frames;
+	uint32_t score;
+	uint32_t name_length;
+	uint64_t bytes;
+};
+
+/* Each segment is this, then `state_bytes` bytes of keyframe (a `board_save()` of the board after `frame` frames, or nothing for the first segment, whose board comes from the seed), then `moves_bytes` bytes of moves from there on.  The moves are the directions the snake went in (`moved` in `struct board`, from before the edge of a sphere turned it), run-length encoded:  each run is a little-endian base-128 varint of `(frames << 2) | (direction - 1)`.  Runs never cross from one segment into the next. */
+struct replay_segment {
+	uint64_t frame;
+	uint32_t state_bytes;
+	uint32_t moves_bytes;
+};
+
+/* Since version 3, the stream starts with these 8 bytes, and a game is written a part at a time while it's played, so that a game that's cut off (by a crash, say) is still there up to its last part, and a long game doesn't have to be kept in memory.  Several games can be being recorded at once, so their parts are mixed together in the file; each part is this, then `bytes` bytes of the game, carrying on from where its last part stopped.  The games are numbered in the order that their first parts are in the file.  A game that's shorter than `REPLAY_KEYFRAME_INTERVAL` frames is written in one part when it's over; a longer one has a part for everything up to each keyframe, written when the keyframe is reached, and then one for the rest. */
+#define REPLAY_PARTS_MAGIC "GAKEPRT"
+
+struct replay_part {
+	uint64_t game;
+	uint64_t frames; /* How far the game had got by the end of this part. */
+	uint32_t score; /* And what its score was by then. */
+	uint32_t last; /* Whether the game was over. */
+	uint64_t bytes;
+};
+
+/* The index is these, then a `struct replay_index_tail`, both after the end of the gzip stream.  Each entry is a place where the compressor was fully flushed, so raw inflation can start from `offset`:  the header of a game if `frame` is 0, and the segment with that frame's keyframe otherwise.  Only games long enough to have keyframes are indexed; the rest are quick enough to find by reading. */
+struct replay_index_entry {
+	uint64_t game;
+	uint64_t frame;
+	uint64_t offset;
+	uint64_t bytes; /* How much of the game is left from there:  bytes before version 3, and frames since, or `UINT64_MAX` if the game never ended. */
+};
+
+struct replay_index_tail {
+	uint64_t entries;
+	char magic[8]; /* "GAKEIDX" */
+};
+
+/* A keyframe every this many frames.  Seeking never has to step more than this. */
+#define REPLAY_KEYFRAME_INTERVAL 4096
+
+struct replay_file;
+
+/* One game being recorded.  One of these that's been zeroed isn't recording, so recording it is free. */
+struct replay {
+	struct replay_header header;
+	const char * name;
+	struct replay_file * file;
+	uint8_t * data; /* The segments that haven't been written out yet. */
+	size_t used;
+	size_t allocated;
+	size_t segment; /* Where the last segment starts in `data`. */
+	uint64_t next_keyframe;
+	enum gake_direction direction;
+	uint64_t run;
+	uint64_t game; /* `UINT64_MAX` until its first part has been written. */
+	size_t first_entry; /* Where its first entry is in the file's index, or `SIZE_MAX` if it doesn't have one. */
+	uint64_t parted_frames; /* How far the game had got by the end of its last part. */
+	uint32_t parted_score;
+	bool recording;
+	bool broken; /* Ran out of memory or disk space at some point, so what's left of it can't be written out. */
+};
+
+/* Games from several threads can be written to the same file. */
+struct replay_file {
+	gzFile file;
+	char * filename;
+	pthread_mutex_t lock;
+	uint64_t games;
+	uint64_t lost; /* Games that couldn't be written, or only partly. */
+	struct replay_index_entry * index;
+	size_t entries;
+	size_t allocated;
+};
+
+extern void replay_run(struct replay * replay);
+extern void replay_keyframe(struct replay * replay, const struct board * board);
+
+/* Call after each step of the board. */
+static inline void replay_frame(struct replay * replay, const struct board * board)
+{
+	if (!replay->recording)
+		return;
+	if (board->moved != replay->direction && replay->run > 0)
+		replay_run(replay);
+	replay->direction = board->moved;
+	replay->run++;
+	if (++replay->header.frames == replay->next_keyframe)
+		replay_keyframe(replay, board);
+}
+
+extern void replay_begin(struct replay_file * file, struct replay * replay, const struct board * board, uint64_t seed, const char * name);
+extern void replay_free(struct replay * replay);
+extern bool replay_open(struct replay_file * file, const char * filename);
+extern bool replay_write(struct replay * replay, const struct board * board);
+extern void replay_close(struct replay_file * file);
+
+#endif/*ndef REPLAY_H*/
@@ -0,0 +1,104 @@
+/* LICENSE
+ *
+ * Copyright © 2021 Blue-Maned_Hawk.  All rights reserved.
+ *
+ * This software should have come with a file called LICENSE.  In case of any difference between this comment and that file, that file is the authority.  (If you did not recieve that file, it's a violation of the license.  Please report it to me.)
+ *
+ * This project is copylefted.  You may freely use, distribute, and modify this software, to the extent permitted by law, so long as you do not attempt to claim such activities are condoned by the author, you distribute the license file with any distributions of this software, you release any modifications under a similar license, and you do not attempt to claim that modified software is the original software.
+ *
+ * This license does not apply to software created with the API of this software (thought it does apply to the API itself); it also does not apply to any rule files, all of which must be placed in the public domain.
+ *
+ * This software links to zlib, which is under the zlib license, available at https://www.zlib.net/zlib_license.html.
+ *
+ * This software dynamically links to SDL2, which is under a separate instance of the zlib license, available at https://libsdl.org/license.php.
+ *
+ * This software dynamically links to libgcrypt, which is under the GNU LGPL2.1+, available at https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=COPYING;h=ccbbaf61b794c7aaea10dffb486095fdc8f3a44a;hb=HEAD.
+ *
+ * This license does not apply to trademarks or patents.
+ *
+ * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
+
+/* This file decides how many simulation ticks to run before each frame is drawn, so that the speed of the game doesn't depend on the speed of the display.  It's also where the anti-cheat slowdown check lives:  that looks at how long each tick took to simulate, not at how long a frame took to draw, so running the game faster than real time doesn't count as slowing down.  Nor does the time spent waiting for the loaded programs to move, which has its own budget (`-t`) and its own penalties.
+ *
+ * When reading this file, you are expected to have access to and generally understand the following documents:
+ * 	· Latest draft of C2x:  http://www.open-std.org/JTC1/SC22/WG14/www/docs/n2596.pdf
+ * 	· The Clang compiler user(?) manual:  https://clang.llvm.org/docs/UsersManual.html
+ * 	· The latest POSIX specification:  https://pubs.opengroup.org/onlinepubs/9699919799/mindex.html */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "Schedule.h"
+#include "Crash.h"
+#include "Logging.h"
+#include "Timing.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+static const uint64_t tick_ns = 1000000000 / 36;
+/* A tick that takes longer than this to simulate is too slow.  This is the same 27 ms that the whole frame used to get. */
+static const uint64_t tick_budget_ns = 27000000;
+/* If real time gets this many ticks ahead of the simulation, the rest are dropped instead of being caught up on all at once. */
+static const int max_catch_up = 8;
+
+void schedule_init(struct schedule * schedule, enum schedule_mode mode, int per_frame)
+{
+	*schedule = (struct schedule){
+		.mode = mode,
+		.per_frame = per_frame,
+		.last = timing_now()
+	};
+}
+
+/* How many ticks to run before the next frame is drawn. */
+int schedule_ticks(struct schedule * schedule)
+{
+	uint64_t now = timing_now();
+	int ticks;
+	switch (schedule->mode){
+	case sm_fast:
+		ticks = schedule->per_frame;
+		break;
+	case sm_uncapped:
+		/* Draw every `per_frame` ticks; with 0, never draw, but still come back often enough to handle events. */
+		ticks = schedule->per_frame > 0 ? schedule->per_frame : 1024;
+		break;
+	default:
+		schedule->owed += now - schedule->last;
+		ticks = schedule->owed / tick_ns;
+		if (ticks > max_catch_up){
+			ticks = max_catch_up;
+			schedule->owed = 0;
+		} else {
+			schedule->owed -= ticks * tick_ns;
+		}
+		/* Don't spin if there's nothing to do yet and the display isn't holding us back. */
+		if (ticks == 0)
+			nanosleep(&(struct timespec){ 0, 1000000 }, NULL);
+		break;
+	}
+	schedule->last = now;
+	return ticks;
+}
+
+bool schedule_render(const struct schedule * schedule)
+{
+	return schedule->mode != sm_uncapped || schedule->per_frame > 0;
+}
+
+/* `started` is when the tick started, from `timing_now()`, and `waited` is how much of it was spent waiting for the programs, from `pool_run_frame()`. */
+void schedule_tick_done(struct schedule * schedule, uint64_t started, uint64_t waited)
+{
+	schedule->ticks++;
+	if (timing_now() - started - waited > tick_budget_ns){
+		schedule->missed++;
+		if (schedule->missed % 36 == 0){
+			logmsg(lp_note, lc_env, "Slowdown detected.  Continued slowdown could result in a crash.");
+		}
+		if (schedule->missed > 360){
+			crash(0x0E, "No extra information.");
+		}
+	} else if (schedule->missed > 0){
+		schedule->missed--;
+	}
+}
@@ -0,0 +1,47 @@
+/* LICENSE
+ *
+ * Copyright © 2021 Blue-Maned_Hawk.  All rights reserved.
+ *
+ * This software should have come with a file called LICENSE.  In case of any difference between this comment and that file, that file is the authority.  (If you did not recieve that file, it's a violation of the license.  Please report it to me.)
+ *
+ * This project is copylefted.  You may freely use, distribute, and modify this software, to the extent permitted by law, so long as you do not attempt to claim such activities are condoned by the author, you distribute the license file with any distributions of this software, you release any modifications under a similar license, and you do not attempt to claim that modified software is the original software.
+ *
+ * This license does not apply to software created with the API of this software (thought it does apply to the API itself); it also does not apply to any rule files, all of which must be placed in the public domain.
+ *
+ * This software links to zlib, which is under the zlib license, available at https://www.zlib.net/zlib_license.html.
+ *
+ * This software dynamically links to SDL2, which is under a separate instance of the zlib license, available at https://libsdl.org/license.php.
+ *
+ * This software dynamically links to libgcrypt, which is under the GNU LGPL2.1+, available at https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=COPYING;h=ccbbaf61b794c7aaea10dffb486095fdc8f3a44a;hb=HEAD.
+ *
+ * This license does not apply to trademarks or patents.
+ *
+ * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
+
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+enum schedule_mode {
+	sm_realtime, /* 36 ticks a second, drawn as often as the display allows. */
+	sm_fast, /* A fixed number of ticks for every frame drawn. */
+	sm_uncapped /* Ticks as fast as possible, drawing every so many ticks (or never). */
+};
+
+struct schedule {
+	enum schedule_mode mode;
+	int per_frame; /* Ticks per frame drawn for `sm_fast`; ticks between frames drawn for `sm_uncapped` (0 for never). */
+	uint64_t last;
+	uint64_t owed; /* Nanoseconds of simulation that `sm_realtime` still has to catch up on. */
+	long long ticks;
+	long long missed;
+};
+
+extern void schedule_init(struct schedule * schedule, enum schedule_mode mode, int per_frame);
+extern int schedule_ticks(struct schedule * schedule);
+extern bool schedule_render(const struct schedule * schedule);
+extern void schedule_tick_done(struct schedule * schedule, uint64_t started, uint64_t waited);
+
+#endif/*ndef SCHEDULE_H*/
@@ -18,7 +18,7 @@
  *
  * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
 
-/* This file is for things done during the setup of gake (except the `setup_logging()` function, which is from `Source/Logging.c`).  Currently, this is setting up the signal handler, and sometime after vN.1, this will include handling the arguments sent to Gake.
+/* This file is for things done during the setup of gake (except the `setup_logging()` function, which is from `Source/Logging.c`).  Currently, this is setting up the signal handlers, and sometime after vN.1, this will include handling the arguments sent to Gake.
  *
  * When reading this file, you are expected to have access to and generally understand the following documents:
  * 	· Latest draft of C2x:  http://www.open-std.org/JTC1/SC22/WG14/www/docs/n2596.pdf
@@ -27,6 +27,7 @@
 
 #include <signal.h>
 #include "Crash.h"
+#include "Timing.h"
 #include <stddef.h> /* Heh.  Can't believe that I have to explicitly include this. */
 
 void install_signals(void)
@@ -40,12 +41,16 @@ void install_signals(void)
 		.sa_handler = SIG_IGN
 	};
 	const int sigs_to_handle[16] = {SIGABRT, SIGBUS, SIGFPE, SIGHUP, SIGILL, SIGINT, SIGQUIT, SIGSEGV, SIGTERM, SIGUSR1, SIGSYS, 0};
-	const int sigs_to_ign[8] = {SIGALRM, SIGPIPE, SIGUSR2, SIGVTALRM, 0};
+	const struct sigaction timing = {
+		.sa_handler = timing_signal
+	};
+	const int sigs_to_ign[8] = {SIGALRM, SIGPIPE, SIGVTALRM, 0};
 	for (register unsigned int i = 0; sigs_to_handle[i] != 0; i++){
 		sigaction(sigs_to_handle[i], &act, NULL);
 	}
 	for (register unsigned int i = 0; sigs_to_ign[i] != 0; i++){
 		sigaction(sigs_to_ign[i], &ign, NULL);
 	}
+	sigaction(SIGUSR2, &timing, NULL); /* Dumps the timing histograms to the log; see `Source/Timing.c`. */
 
 }
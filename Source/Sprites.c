@@ -0,0 +1,194 @@
+/* LICENSE
+ *
+ * Copyright © 2021 Blue-Maned_Hawk.  All rights reserved.
+ *
+ * This software should have come with a file called LICENSE.  In case of any difference between this comment and that file, that file is the authority.  (If you did not recieve that file, it's a violation of the license.  Please report it to me.)
+ *
+ * This project is copylefted.  You may freely use, distribute, and modify this software, to the extent permitted by law, so long as you do not attempt to claim such activities are condoned by the author, you distribute the license file with any distributions of this software, you release any modifications under a similar license, and you do not attempt to claim that modified software is the original software.
+ *
+ * This license does not apply to software created with the API of this software (thought it does apply to the API itself); it also does not apply to any rule files, all of which must be placed in the public domain.
+ *
+ * This software links to zlib, which is under the zlib license, available at https://www.zlib.net/zlib_license.html.
+ *
+ * This software dynamically links to SDL2, which is under a separate instance of the zlib license, available at https://libsdl.org/license.php.
+ *
+ * This software dynamically links to libgcrypt, which is under the GNU LGPL2.1+, available at https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=COPYING;h=ccbbaf61b794c7aaea10dffb486095fdc8f3a44a;hb=HEAD.
+ *
+ * This license does not apply to trademarks or patents.
+ *
+ * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
+
+/* This file is for drawing the board out of the game textures, as one batch of sprites.
+ *
+ * When reading this file, you are expected to have access to and generally understand the following documents:
+ * 	· Latest draft of C2x:  http://www.open-std.org/JTC1/SC22/WG14/www/docs/n2596.pdf
+ * 	· The Clang compiler user(?) manual:  https://clang.llvm.org/docs/UsersManual.html
+ * 	· The latest POSIX specification:  https://pubs.opengroup.org/onlinepubs/9699919799/mindex.html
+ * 	· The SDL2 wiki:  https://wiki.libsdl.org/ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "Sprites.h"
+#include <stdlib.h>
+
+/* The game textures, in the order that they're cut out of `Assets/Textures.png`. */
+enum tile {
+	tile_head,
+	tile_body,
+	tile_tail,
+	tile_apple,
+	tile_count
+};
+
+static const int tile_size = 8;
+
+/* Puts the tiles side by side in one texture, so that they can all be drawn in the same call. */
+bool sprites_start(struct sprites * sprites, SDL_Renderer * renderer, SDL_Surface ** tiles)
+{
+	*sprites = (struct sprites){ .patched = UINT32_MAX };
+	SDL_Surface * atlas = SDL_CreateRGBSurfaceWithFormat(0, tile_size * tile_count, tile_size, 32, SDL_PIXELFORMAT_RGBA32);
+	if (atlas == NULL)
+		return 0;
+	for (register int i = 0; i < tile_count; i++)
+		SDL_BlitSurface(tiles[i], NULL, atlas, &(SDL_Rect){ i * tile_size, 0, tile_size, tile_size });
+	sprites->atlas = SDL_CreateTextureFromSurface(renderer, atlas);
+	SDL_FreeSurface(atlas);
+	if (sprites->atlas == NULL)
+		return 0;
+	SDL_SetTextureBlendMode(sprites->atlas, SDL_BLENDMODE_BLEND);
+	return 1;
+}
+
+void sprites_stop(struct sprites * sprites)
+{
+	if (sprites->atlas != NULL)
+		SDL_DestroyTexture(sprites->atlas);
+	free(sprites->vertices);
+	free(sprites->indices);
+	*sprites = (struct sprites){ .patched = UINT32_MAX };
+}
+
+/* Quad `quad` of `indices` draws quad `drawn` of the ring; the apple is quad `ring`. */
+static void point(struct sprites * sprites, uint32_t quad, uint32_t drawn)
+{
+	int * at = &sprites->indices[quad * 6];
+	int first = drawn * 4;
+	at[0] = first;
+	at[1] = first + 1;
+	at[2] = first + 2;
+	at[3] = first + 1;
+	at[4] = first + 3;
+	at[5] = first + 2;
+}
+
+/* The smallest ring that's worth having, so that a short snake doesn't have it growing every few apples. */
+static const uint32_t least_ring = 64;
+
+/* Makes room for a ring of `ring` quads.  What was in the ring before isn't kept, so everything is placed again next time. */
+static bool reserve(struct sprites * sprites, uint32_t ring)
+{
+	sprites->board = NULL;
+	sprites->patched = UINT32_MAX;
+	SDL_Vertex * vertices = realloc(sprites->vertices, (ring + 1) * 4 * sizeof (SDL_Vertex));
+	if (vertices != NULL)
+		sprites->vertices = vertices;
+	int * indices = realloc(sprites->indices, (ring * 2 + 1) * 6 * sizeof (int));
+	if (indices != NULL)
+		sprites->indices = indices;
+	if (vertices == NULL || indices == NULL){
+		sprites->ring = 0;
+		return 0;
+	}
+	sprites->ring = ring;
+	for (register uint32_t quad = 0; quad < ring * 2; quad++)
+		point(sprites, quad, quad & (ring - 1));
+	return 1;
+}
+
+static void place(struct sprites * sprites, uint32_t quad, uint32_t cell, enum tile tile)
+{
+	float size = sprites->area.w / sprites->width;
+	float x = sprites->area.x + (cell % sprites->width) * size;
+	float y = sprites->area.y + (cell / sprites->width) * size;
+	float left = (float)tile / tile_count;
+	float right = (float)(tile + 1) / tile_count;
+	SDL_Color white = { 0xFF, 0xFF, 0xFF, 0xFF };
+	SDL_Vertex * at = &sprites->vertices[quad * 4];
+	at[0] = (SDL_Vertex){ { x, y }, white, { left, 0 } };
+	at[1] = (SDL_Vertex){ { x + size, y }, white, { right, 0 } };
+	at[2] = (SDL_Vertex){ { x, y + size }, white, { left, 1 } };
+	at[3] = (SDL_Vertex){ { x + size, y + size }, white, { right, 1 } };
+}
+
+/* Draws `board` as big as it'll fit in `area`, keeping the cells square, on a background of the renderer's draw colour. */
+void sprites_draw(struct sprites * sprites, SDL_Renderer * renderer, const struct board * board, SDL_FRect area)
+{
+	/* Both rings are powers of two, so as long as this one is no longer than the board's, a run of slots in that one is a run of quads in this one. */
+	uint32_t slots = board->mask + 1;
+	uint32_t ring = sprites->ring > slots ? 0 : sprites->ring;
+	if (ring < board->length){
+		ring = ring < least_ring ? least_ring : ring;
+		while (ring < board->length)
+			ring <<= 1;
+		ring = ring > slots ? slots : ring;
+	}
+	if (sprites->atlas == NULL || (ring != sprites->ring && !reserve(sprites, ring)))
+		return;
+	uint32_t wrap = ring - 1;
+
+	float size = area.w / board->width < area.h / board->height ? area.w / board->width : area.h / board->height;
+	SDL_FRect fitted = {
+		.x = area.x + (area.w - size * board->width) / 2,
+		.y = area.y + (area.h - size * board->height) / 2,
+		.w = size * board->width,
+		.h = size * board->height
+	};
+
+	uint32_t tail = (board->head - board->length + 1) & board->mask;
+	/* A step only ever moves the head on by one slot, so if fewer frames have gone by than the snake is long, everything from the old head to the new one is all that changed. */
+	bool fresh = board != sprites->board || board->epoch != sprites->epoch || board->frames < sprites->frames || board->frames - sprites->frames >= board->length || board->width != sprites->width || board->height != sprites->height || fitted.x != sprites->area.x || fitted.y != sprites->area.y || fitted.w != sprites->area.w;
+	sprites->width = board->width;
+	sprites->height = board->height;
+	sprites->area = fitted;
+	if (fresh){
+		for (register uint32_t i = 0; i < board->length; i++){
+			uint32_t slot = (tail + i) & board->mask;
+			place(sprites, slot & wrap, board->body[slot], tile_body);
+		}
+	} else {
+		for (register uint32_t slot = sprites->head; slot != board->head; slot = (slot + 1) & board->mask)
+			place(sprites, slot & wrap, board->body[slot], tile_body);
+	}
+	place(sprites, tail & wrap, board->body[tail], tile_tail);
+	place(sprites, board->head & wrap, board->body[board->head], tile_head);
+	sprites->board = board;
+	sprites->epoch = board->epoch;
+	sprites->frames = board->frames;
+	sprites->head = board->head;
+
+	/* The apple goes just past the end of the snake's run, and whatever that quad was gets put back next time. */
+	if (sprites->patched != UINT32_MAX)
+		point(sprites, sprites->patched, sprites->patched & wrap);
+	sprites->patched = UINT32_MAX;
+	uint32_t quads = board->length;
+	if (board->apple != UINT32_MAX){
+		place(sprites, ring, board->apple, tile_apple);
+		sprites->patched = (tail & wrap) + quads;
+		point(sprites, sprites->patched, ring);
+		quads++;
+	}
+
+	sprites->first = tail & wrap;
+	sprites->quads = quads;
+	SDL_RenderFillRectF(renderer, &fitted);
+	SDL_RenderGeometry(renderer, sprites->atlas, sprites->vertices, (ring + 1) * 4, &sprites->indices[sprites->first * 6], quads * 6);
+}
+
+/* Draws whatever was drawn last time again, without looking at the board, which might be in the middle of being changed. */
+void sprites_redraw(struct sprites * sprites, SDL_Renderer * renderer)
+{
+	if (sprites->board == NULL)
+		return;
+	SDL_RenderFillRectF(renderer, &sprites->area);
+	SDL_RenderGeometry(renderer, sprites->atlas, sprites->vertices, (sprites->ring + 1) * 4, &sprites->indices[sprites->first * 6], sprites->quads * 6);
+}
@@ -0,0 +1,54 @@
+/* LICENSE
+ *
+ * Copyright © 2021 Blue-Maned_Hawk.  All rights reserved.
+ *
+ * This software should have come with a file called LICENSE.  In case of any difference between this comment and that file, that file is the authority.  (If you did not recieve that file, it's a violation of the license.  Please report it to me.)
+ *
+ * This project is copylefted.  You may freely use, distribute, and modify this software, to the extent permitted by law, so long as you do not attempt to claim such activities are condoned by the author, you distribute the license file with any distributions of this software, you release any modifications under a similar license, and you do not attempt to claim that modified software is the original software.
+ *
+ * This license does not apply to software created with the API of this software (thought it does apply to the API itself); it also does not apply to any rule files, all of which must be placed in the public domain.
+ *
+ * This software links to zlib, which is under the zlib license, available at https://www.zlib.net/zlib_license.html.
+ *
+ * This software dynamically links to SDL2, which is under a separate instance of the zlib license, available at https://libsdl.org/license.php.
+ *
+ * This software dynamically links to libgcrypt, which is under the GNU LGPL2.1+, available at https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=COPYING;h=ccbbaf61b794c7aaea10dffb486095fdc8f3a44a;hb=HEAD.
+ *
+ * This license does not apply to trademarks or patents.
+ *
+ * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
+
+#ifndef SPRITES_H
+#define SPRITES_H
+
+#include "SDL.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include "Board.h"
+
+/* Draws a board with one `SDL_RenderGeometry()` call.  There's a ring of quads of vertices, a power of two of them that's at least as long as the snake, and slot `slot` of the board's body ring is drawn by quad `slot & (quads - 1)`, so when the snake moves, only the quads that it moved into (and the ones that stopped being the head or became the tail) have to be worked out again.  The ring only grows when the snake has outgrown it, so it's about as big as the snake and not as big as the board.  The part of the ring that the snake is in is always one run of `indices`, which has every quad in it twice so that the run doesn't have to wrap around. */
+struct sprites {
+	SDL_Texture * atlas;
+	SDL_Vertex * vertices; /* Four for each quad of the ring, then four for the apple. */
+	int * indices; /* Six for each quad of the ring, twice over, and room for the apple after the last one. */
+	uint32_t ring; /* How many quads there are in the ring. */
+	uint32_t patched; /* Where in `indices` (counted in quads) the apple was put last time, so that it can be put back; `UINT32_MAX` if nowhere. */
+	/* What was drawn last time. */
+	const struct board * board;
+	uint64_t epoch;
+	long long frames;
+	uint32_t head;
+	int width;
+	int height;
+	SDL_FRect area;
+	/* What was handed to `SDL_RenderGeometry()` last time, for `sprites_redraw()`. */
+	uint32_t first;
+	uint32_t quads;
+};
+
+extern bool sprites_start(struct sprites * sprites, SDL_Renderer * renderer, SDL_Surface ** tiles);
+extern void sprites_draw(struct sprites * sprites, SDL_Renderer * renderer, const struct board * board, SDL_FRect area);
+extern void sprites_redraw(struct sprites * sprites, SDL_Renderer * renderer);
+extern void sprites_stop(struct sprites * sprites);
+
+#endif/*ndef SPRITES_H*/
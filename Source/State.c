@@ -28,6 +28,8 @@
 #include "SDL.h"
 #include <stdbool.h>
 #include "State.h"
+#include "Board.h"
+#include "Sprites.h"
 
 static const short winheight = 480;
 static const short winwidth = 640;
@@ -57,6 +59,17 @@ MKRECT_XYWH(quitgrophset, 21/32, 13/24, 3/16, 1/4);
 static enum state selected = menu;
 static enum state hover = menu;
 
+/* The menu only looks different when something's hovered over or picked, so it's only drawn then, into `menu_surface`, and uploaded to `menu_texture`; every other frame, the texture is just copied to the screen.  Both are made the first time the menu is shown, and kept until `render_cleanup()`. */
+static SDL_Surface * menu_surface = NULL;
+static SDL_Texture * menu_texture = NULL;
+static bool menu_drawn = 0;
+static enum state drawn_hover;
+static enum state drawn_selected;
+
+/* The game textures, made into one texture the first time a game is shown. */
+static struct sprites sprites;
+static bool sprites_made = 0;
+
 enum state render_menu(struct mouse the_mouse, SDL_Keycode key, SDL_Renderer * renderer, SDL_Surface ** assets)
 {
 	SDL_Point mousepos = {
@@ -64,21 +77,12 @@ enum state render_menu(struct mouse the_mouse, SDL_Keycode key, SDL_Renderer * r
 		.y = the_mouse.y
 	};
 	bool click = the_mouse.mask & SDL_BUTTON_LMASK;
-	SDL_Surface * surface = SDL_CreateRGBSurfaceWithFormat(0, winwidth, winheight, 32, SDL_PIXELFORMAT_RGBA32);
-	int32_t light_blue_mask = SDL_MapRGBA(surface->format, 0x7f, 0x7f, 0xff, 0xff);
-	int32_t blue_mask = SDL_MapRGBA(surface->format, 0x00, 0x00, 0xff, 0xff);
-	int32_t dark_blue_mask = SDL_MapRGBA(surface->format, 0x00, 0x00, 0x7f, 0xff);
-	int32_t light_red_mask = SDL_MapRGBA(surface->format, 0xff, 0x7f, 0x7f, 0xff);
-	int32_t red_mask = SDL_MapRGBA(surface->format, 0xff, 0x00, 0x00, 0xff);
-	int32_t dark_red_mask = SDL_MapRGBA(surface->format, 0x7f, 0x00, 0x00, 0xff);
 
 	if (key == SDLK_INSERT || key == SDLK_RETURN || key == SDLK_DELETE || key == SDLK_ESCAPE)
 		click++;
 
-	if (selected != menu && !click){
-		SDL_FreeSurface(surface);
+	if (selected != menu && !click)
 		return selected;
-	}
 
 #define CHECK_MOUSE_FOR(rect)\
 	if (SDL_PointInRect(&mousepos, &( rect ## button ))){\
@@ -113,21 +117,99 @@ enum state render_menu(struct mouse the_mouse, SDL_Keycode key, SDL_Renderer * r
 		SDL_BlitScaled(associated_asset, NULL, surface, &(the_button ## grophset ));\
 	}
 
-	RENDER(game, assets[0], blue);
-	RENDER(prgm, assets[1], blue);
-	RENDER(quit, assets[2], red);
+	if (menu_surface == NULL){
+		menu_surface = SDL_CreateRGBSurfaceWithFormat(0, winwidth, winheight, 32, SDL_PIXELFORMAT_RGBA32);
+		menu_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, winwidth, winheight);
+		if (menu_surface == NULL || menu_texture == NULL){
+			render_cleanup();
+			return menu;
+		}
+	}
 
-	SDL_Texture * texture = SDL_CreateTextureFromSurface(renderer, surface);\
-	SDL_RenderCopy(renderer, texture, NULL, NULL);
+	if (!menu_drawn || hover != drawn_hover || selected != drawn_selected){
+		SDL_Surface * surface = menu_surface;
+		int32_t light_blue_mask = SDL_MapRGBA(surface->format, 0x7f, 0x7f, 0xff, 0xff);
+		int32_t blue_mask = SDL_MapRGBA(surface->format, 0x00, 0x00, 0xff, 0xff);
+		int32_t dark_blue_mask = SDL_MapRGBA(surface->format, 0x00, 0x00, 0x7f, 0xff);
+		int32_t light_red_mask = SDL_MapRGBA(surface->format, 0xff, 0x7f, 0x7f, 0xff);
+		int32_t red_mask = SDL_MapRGBA(surface->format, 0xff, 0x00, 0x00, 0xff);
+		int32_t dark_red_mask = SDL_MapRGBA(surface->format, 0x7f, 0x00, 0x00, 0xff);
+
+		SDL_FillRect(surface, NULL, 0);
+		RENDER(game, assets[0], blue);
+		RENDER(prgm, assets[1], blue);
+		RENDER(quit, assets[2], red);
+
+		SDL_UpdateTexture(menu_texture, NULL, surface->pixels, surface->pitch);
+		drawn_hover = hover;
+		drawn_selected = selected;
+		menu_drawn = 1;
+	}
 
-	SDL_DestroyTexture(texture);
-	SDL_FreeSurface(surface);
+	SDL_RenderCopy(renderer, menu_texture, NULL, NULL);
 
 	return menu;
 }
 
-enum state render_game(long long frames [[maybe_unused]], SDL_Keycode key [[maybe_unused]], struct mouse the_mouse [[maybe_unused]], SDL_Renderer * renderer [[maybe_unused]], SDL_Surface ** assets [[maybe_unused]]){
-	return menu;
+/* Call whenever the menu comes back from anything else, so that it waits to be picked from again instead of going straight back to whatever was picked last time. */
+void render_menu_reset(void)
+{
+	selected = menu;
+	hover = menu;
+}
+
+/* Call before the renderer is destroyed. */
+void render_cleanup(void)
+{
+	if (menu_texture != NULL)
+		SDL_DestroyTexture(menu_texture);
+	SDL_FreeSurface(menu_surface);
+	menu_texture = NULL;
+	menu_surface = NULL;
+	menu_drawn = 0;
+	if (sprites_made)
+		sprites_stop(&sprites);
+	sprites_made = 0;
+}
+
+/* All of the actual game happens in `Source/Board.c`; this just draws whatever's on the board. */
+/* `board` is NULL while the board being shown is still being moved by its program, in which case what was drawn last time is drawn again. */
+enum state render_game(long long frames [[maybe_unused]], SDL_Keycode key, struct mouse the_mouse [[maybe_unused]], SDL_Renderer * renderer, SDL_Surface ** assets, const struct board * board){
+	if (key == SDLK_ESCAPE || (board != NULL && !board->alive))
+		return menu;
+
+	if (!sprites_made)
+		sprites_made = sprites_start(&sprites, renderer, assets);
+
+	SDL_SetRenderDrawColor(renderer, 0x20, 0x20, 0x40, 0xFF);
+	if (sprites_made){
+		if (board != NULL)
+			sprites_draw(&sprites, renderer, board, (SDL_FRect){ 0, 0, winwidth, winheight });
+		else
+			sprites_redraw(&sprites, renderer);
+		return game;
+	}
+	if (board == NULL)
+		return game; /* The old way doesn't keep anything to draw again. */
+
+	/* If the textures couldn't be made into a texture, there's still the old way of drawing it, one rectangle per cell, although that only works for boards with fewer cells across than the window has pixels. */
+	int cellsize = winwidth / board->width < winheight / board->height ? winwidth / board->width : winheight / board->height;
+	int xoff = (winwidth - cellsize * board->width) / 2;
+	int yoff = (winheight - cellsize * board->height) / 2;
+	SDL_RenderFillRect(renderer, &(SDL_Rect){ xoff, yoff, cellsize * board->width, cellsize * board->height });
+
+	SDL_SetRenderDrawColor(renderer, 0x00, 0xC0, 0x00, 0xFF);
+	for (register uint32_t i = 0; i < board->length; i++){
+		uint32_t cell = board_segment(board, i);
+		SDL_RenderFillRect(renderer, &(SDL_Rect){ xoff + (cell % board->width) * cellsize, yoff + (cell / board->width) * cellsize, cellsize, cellsize });
+	}
+
+	if (board->apple != UINT32_MAX){
+		SDL_SetRenderDrawColor(renderer, 0xFF, 0x00, 0x00, 0xFF);
+		SDL_RenderFillRect(renderer, &(SDL_Rect){ xoff + (board->apple % board->width) * cellsize, yoff + (board->apple / board->width) * cellsize, cellsize, cellsize });
+	}
+
+	return game;
 }
 
 enum state render_prgm(struct mouse the_mouse [[maybe_unused]], SDL_Keycode key [[maybe_unused]], SDL_Renderer * renderer [[maybe_unused]]){
@@ -23,6 +23,7 @@
 
 #include "SDL.h"
 #include <stdint.h>
+#include "Board.h"
 
 struct mouse {
 	int x;
@@ -38,7 +39,9 @@ enum state {
 };
 
 extern enum state render_menu(struct mouse the_mouse, SDL_Keycode key, SDL_Renderer * renderer, SDL_Surface ** assets);
-extern enum state render_game(long long frames, SDL_Keycode key, struct mouse the_mouse, SDL_Renderer * renderer, SDL_Surface ** assets);
+extern enum state render_game(long long frames, SDL_Keycode key, struct mouse the_mouse, SDL_Renderer * renderer, SDL_Surface ** assets, const struct board * board);
 extern enum state render_prgm(struct mouse the_mouse, SDL_Keycode key, SDL_Renderer * renderer);
+extern void render_menu_reset(void);
+extern void render_cleanup(void);
 
 #endif/*ndef STATE_H*/
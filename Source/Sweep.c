@@ -0,0 +1,282 @@
+/* LICENSE
+ *
+ * Copyright © 2021 Blue-Maned_Hawk.  All rights reserved.
+ *
+ * This software should have come with a file called LICENSE.  In case of any difference between this comment and that file, that file is the authority.  (If you did not recieve that file, it's a violation of the license.  Please report it to me.)
+ *
+ * This project is copylefted.  You may freely use, distribute, and modify this software, to the extent permitted by law, so long as you do not attempt to claim such activities are condoned by the author, you distribute the license file with any distributions of this software, you release any modifications under a similar license, and you do not attempt to claim that modified software is the original software.
+ *
+ * This license does not apply to software created with the API of this software (thought it does apply to the API itself); it also does not apply to any rule files, all of which must be placed in the public domain.
+ *
+ * This software links to zlib, which is under the zlib license, available at https://www.zlib.net/zlib_license.html.
+ *
+ * This software dynamically links to SDL2, which is under a separate instance of the zlib license, available at https://libsdl.org/license.php.
+ *
+ * This software dynamically links to libgcrypt, which is under the GNU LGPL2.1+, available at https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=COPYING;h=ccbbaf61b794c7aaea10dffb486095fdc8f3a44a;hb=HEAD.
+ *
+ * This license does not apply to trademarks or patents.
+ *
+ * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
+
+/* This file plays one game per seed per program over a range of seeds, using every core.  Games can differ in length by orders of magnitude, so the seeds aren't split up ahead of time; instead, each worker owns a range of seeds and takes from the bottom of it, and a worker that runs out steals the top half of somebody else's.  A range is two 32-bit numbers packed into one atomic 64-bit word, so both taking and stealing are a single compare-and-swap.
+ *
+ * When reading this file, you are expected to have access to and generally understand the following documents:
+ * 	· Latest draft of C2x:  http://www.open-std.org/JTC1/SC22/WG14/www/docs/n2596.pdf
+ * 	· The Clang compiler user(?) manual:  https://clang.llvm.org/docs/UsersManual.html
+ * 	· The latest POSIX specification:  https://pubs.opengroup.org/onlinepubs/9699919799/mindex.html */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "Sweep.h"
+#include "Board.h"
+#include "Logging.h"
+#include "Program.h"
+#include "Replay.h"
+#include "Timing.h"
+#include "Trace.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* The results, as columns.  Entry `i` is game `i`, which is seed `first_seed + i % seeds` played by program `i / seeds`. */
+struct sweep_results {
+	uint64_t * seed;
+	uint32_t * score;
+	uint32_t * length;
+	uint64_t * frames;
+	uint64_t * wall_ns;
+	uint8_t * program;
+};
+
+struct sweep {
+	struct program * programs;
+	int width;
+	int height;
+	enum gake_topology topology;
+	uint64_t first_seed;
+	uint64_t seeds;
+	struct sweep_results results;
+	struct replay_file * replays; /* NULL if the games aren't being recorded. */
+	unsigned nworkers;
+	_Atomic uint64_t * ranges; /* One per worker:  the bottom of the range in the low half, the top (exclusive) in the high half. */
+};
+
+struct sweep_worker {
+	struct sweep * sweep;
+	unsigned index;
+	pthread_t thread;
+};
+
+static inline uint64_t pack(uint32_t lo, uint32_t hi)
+{
+	return (uint64_t)hi << 32 | lo;
+}
+
+/* Takes one game from the bottom of the worker's own range.  Returns 0 if it's empty. */
+static bool take(_Atomic uint64_t * range, uint32_t * game)
+{
+	uint64_t old = atomic_load_explicit(range, memory_order_relaxed);
+	for (;;){
+		uint32_t lo = old & 0xFFFFFFFF;
+		uint32_t hi = old >> 32;
+		if (lo >= hi)
+			return 0;
+		if (atomic_compare_exchange_weak_explicit(range, &old, pack(lo + 1, hi), memory_order_acquire, memory_order_relaxed)){
+			*game = lo;
+			return 1;
+		}
+	}
+}
+
+/* Steals the top half of somebody else's range and makes it the worker's own.  A range with only one game left isn't worth stealing, since its owner is about to take it.  Returns 0 once there's nothing left to steal anywhere. */
+static bool steal(struct sweep * sweep, unsigned self)
+{
+	for (register unsigned i = 1; i < sweep->nworkers; i++){
+		_Atomic uint64_t * victim = &sweep->ranges[(self + i) % sweep->nworkers];
+		uint64_t old = atomic_load_explicit(victim, memory_order_relaxed);
+		for (;;){
+			uint32_t lo = old & 0xFFFFFFFF;
+			uint32_t hi = old >> 32;
+			if (hi - lo < 2 || lo >= hi)
+				break;
+			uint32_t mid = lo + (hi - lo) / 2;
+			if (atomic_compare_exchange_weak_explicit(victim, &old, pack(lo, mid), memory_order_acq_rel, memory_order_relaxed)){
+				/* Nobody steals from an empty range, so nothing else can be touching ours right now. */
+				atomic_store_explicit(&sweep->ranges[self], pack(mid, hi), memory_order_release);
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+static void play_game(struct sweep * sweep, uint32_t game, struct gake_curstate * state, struct replay * replay)
+{
+	struct program * program = &sweep->programs[game / sweep->seeds];
+	uint64_t seed = sweep->first_seed + game % sweep->seeds;
+	struct board board;
+	uint64_t start = timing_now();
+	long long last_apple = 0;
+	/* Same as in headless mode:  a snake that goes four times the area of the board without eating is just going in circles. */
+	long long starve = 4LL * sweep->width * sweep->height;
+	trace_enter(program->trace);
+
+	if (board_init(&board, sweep->width, sweep->height, sweep->topology, seed)){
+		if (sweep->replays != NULL)
+			replay_begin(sweep->replays, replay, &board, seed, program->name);
+		while (board.alive){
+			unsigned score = board.score;
+			board_describe(&board, state, program->deltas);
+			struct gake_newstate move;
+			if (program->batch != NULL)
+				program->batch(state, &move, 1);
+			else
+				program_call(program, state, &move);
+			board_step(&board, move.direction);
+			replay_frame(replay, &board);
+			if (board.score != score)
+				last_apple = board.frames;
+			else if (board.frames - last_apple > starve)
+				board.alive = 0;
+		}
+	}
+
+	sweep->results.seed[game] = seed;
+	sweep->results.score[game] = board.score;
+	sweep->results.length[game] = board.length;
+	sweep->results.frames[game] = board.frames;
+	sweep->results.wall_ns[game] = timing_now() - start;
+	sweep->results.program[game] = game / sweep->seeds;
+	replay_write(replay, &board);
+	board_free(&board);
+}
+
+static void * sweep_worker(void * arg)
+{
+	struct sweep_worker * worker = arg;
+	struct sweep * sweep = worker->sweep;
+	struct gake_curstate state = { .keys = "" };
+	struct replay replay = {};
+	uint32_t game;
+	do {
+		while (take(&sweep->ranges[worker->index], &game))
+			play_game(sweep, game, &state, &replay);
+	} while (steal(sweep, worker->index));
+	replay_free(&replay);
+	return NULL;
+}
+
+static bool write_results(const struct sweep * sweep, short count, uint64_t games, const char * filename)
+{
+	FILE * file = fopen(filename, "wb");
+	if (file == NULL)
+		return 0;
+	struct sweep_header header = {
+		.magic = "GAKESWP",
+		.version = 1,
+		.programs = count,
+		.count = games,
+		.first_seed = sweep->first_seed,
+		.seeds = sweep->seeds
+	};
+	bool ok = fwrite(&header, sizeof header, 1, file) == 1;
+	for (register short i = 0; i < count; i++)
+		ok &= fwrite(sweep->programs[i].name, sizeof sweep->programs[i].name, 1, file) == 1;
+	ok &= fwrite(sweep->results.seed, sizeof (uint64_t), games, file) == games;
+	ok &= fwrite(sweep->results.score, sizeof (uint32_t), games, file) == games;
+	ok &= fwrite(sweep->results.length, sizeof (uint32_t), games, file) == games;
+	ok &= fwrite(sweep->results.frames, sizeof (uint64_t), games, file) == games;
+	ok &= fwrite(sweep->results.wall_ns, sizeof (uint64_t), games, file) == games;
+	ok &= fwrite(sweep->results.program, sizeof (uint8_t), games, file) == games;
+	return (fclose(file) == 0) & ok;
+}
+
+/* `last_seed` is included in the sweep. */
+bool run_sweep(struct program * programs, short count, int width, int height, enum gake_topology topology, uint64_t first_seed, uint64_t last_seed, const char * filename, struct replay_file * replays)
+{
+	if (last_seed < first_seed || count <= 0)
+		return 0;
+	uint64_t seeds = last_seed - first_seed + 1;
+	uint64_t games = seeds * count;
+	if (seeds == 0 || games / count != seeds || games >= UINT32_MAX){
+		logmsg(lp_err, lc_misc, "A sweep can have at most %u games in it.", UINT32_MAX - 1);
+		return 0;
+	}
+
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	struct sweep sweep = {
+		.programs = programs,
+		.width = width,
+		.height = height,
+		.topology = topology,
+		.first_seed = first_seed,
+		.seeds = seeds,
+		.results = {
+			.seed = calloc(games, sizeof (uint64_t)),
+			.score = calloc(games, sizeof (uint32_t)),
+			.length = calloc(games, sizeof (uint32_t)),
+			.frames = calloc(games, sizeof (uint64_t)),
+			.wall_ns = calloc(games, sizeof (uint64_t)),
+			.program = calloc(games, sizeof (uint8_t))
+		},
+		.replays = replays,
+		.nworkers = cores < 1 ? 1 : cores
+	};
+	if ((uint64_t)sweep.nworkers > games)
+		sweep.nworkers = games;
+	sweep.ranges = calloc(sweep.nworkers, sizeof (_Atomic uint64_t));
+	struct sweep_worker * workers = calloc(sweep.nworkers, sizeof (struct sweep_worker));
+	bool ok = 0;
+	if (sweep.ranges == NULL || workers == NULL || sweep.results.seed == NULL || sweep.results.score == NULL || sweep.results.length == NULL || sweep.results.frames == NULL || sweep.results.wall_ns == NULL || sweep.results.program == NULL){
+		logmsg(lp_err, lc_misc, "Could not allocate room for the results of the sweep.");
+		goto cleanup;
+	}
+
+	/* Everybody starts with an even share; stealing sorts out the rest. */
+	for (register unsigned i = 0; i < sweep.nworkers; i++)
+		atomic_init(&sweep.ranges[i], pack(games * i / sweep.nworkers, games * (i + 1) / sweep.nworkers));
+
+	logmsg(lp_info, lc_misc, "Sweeping seeds %llu to %llu with %hd program%s on %u thread%s…", (unsigned long long)first_seed, (unsigned long long)last_seed, count, count == 1 ? "" : "s", sweep.nworkers, sweep.nworkers == 1 ? "" : "s");
+	uint64_t start = timing_now();
+	unsigned started = 0;
+	for (register unsigned i = 0; i < sweep.nworkers; i++)
+		workers[i] = (struct sweep_worker){ .sweep = &sweep, .index = i };
+	for (register unsigned i = 0; i < sweep.nworkers; i++){
+		if (pthread_create(&workers[i].thread, NULL, sweep_worker, &workers[i]) != 0)
+			break;
+		started++;
+	}
+	for (register unsigned i = 0; i < started; i++)
+		pthread_join(workers[i].thread, NULL);
+	/* The threads that were started steal most of what the ones that couldn't be would have done, but never the last game of a range, so whatever's left gets done here. */
+	for (register unsigned i = started; i < sweep.nworkers; i++)
+		sweep_worker(&workers[i]);
+	double secs = (timing_now() - start) / 1e9;
+
+	unsigned long long frames = 0;
+	for (register uint64_t i = 0; i < games; i++)
+		frames += sweep.results.frames[i];
+	logmsg(lp_info, lc_misc, "Played %llu games (%llu frames) in %.3f seconds.", (unsigned long long)games, frames, secs);
+
+	ok = write_results(&sweep, count, games, filename);
+	if (ok)
+		logmsg(lp_info, lc_misc, "The results of the sweep have been written to %s.", filename);
+	else
+		logmsg(lp_err, lc_misc, "The results of the sweep could not be written to %s.", filename);
+
+cleanup:
+	free(sweep.results.seed);
+	free(sweep.results.score);
+	free(sweep.results.length);
+	free(sweep.results.frames);
+	free(sweep.results.wall_ns);
+	free(sweep.results.program);
+	free(sweep.ranges);
+	free(workers);
+	return ok;
+}
@@ -0,0 +1,125 @@
+/* LICENSE
+ *
+ * Copyright © 2021 Blue-Maned_Hawk.  All rights reserved.
+ *
+ * This software should have come with a file called LICENSE.  In case of any difference between this comment and that file, that file is the authority.  (If you did not recieve that file, it's a violation of the license.  Please report it to me.)
+ *
+ * This project is copylefted.  You may freely use, distribute, and modify this software, to the extent permitted by law, so long as you do not attempt to claim such activities are condoned by the author, you distribute the license file with any distributions of this software, you release any modifications under a similar license, and you do not attempt to claim that modified software is the original software.
+ *
+ * This license does not apply to software created with the API of this software (thought it does apply to the API itself); it also does not apply to any rule files, all of which must be placed in the public domain.
+ *
+ * This software links to zlib, which is under the zlib license, available at https://www.zlib.net/zlib_license.html.
+ *
+ * This software dynamically links to SDL2, which is under a separate instance of the zlib license, available at https://libsdl.org/license.php.
+ *
+ * This software dynamically links to libgcrypt, which is under the GNU LGPL2.1+, available at https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=COPYING;h=ccbbaf61b794c7aaea10dffb486095fdc8f3a44a;hb=HEAD.
+ *
+ * This license does not apply to trademarks or patents.
+ *
+ * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
+
+/* This file measures how long things take, in nanoseconds from the monotonic clock, and keeps the results as log-linear histograms (the same idea as HdrHistogram), so that the rare slow frame shows up in the 99.9th percentile instead of getting averaged away.  The histograms are written to the log when Gake exits, or whenever it gets SIGUSR2.
+ *
+ * When reading this file, you are expected to have access to and generally understand the following documents:
+ * 	· Latest draft of C2x:  http://www.open-std.org/JTC1/SC22/WG14/www/docs/n2596.pdf
+ * 	· The Clang compiler user(?) manual:  https://clang.llvm.org/docs/UsersManual.html
+ * 	· The latest POSIX specification:  https://pubs.opengroup.org/onlinepubs/9699919799/mindex.html */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "Timing.h"
+#include "Logging.h"
+#include <signal.h>
+#include <stdint.h>
+#include <time.h>
+
+volatile sig_atomic_t timing_requested = 0;
+
+static struct histogram phases[tp_count];
+static const char phase_names[tp_count][32] = {
+	"Event polling",
+	"Simulation tick",
+	"Rendering",
+	"Presenting"
+};
+
+uint64_t timing_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static inline unsigned bucket_of(uint64_t ns)
+{
+	if (ns < (1 << HISTOGRAM_SUB_BITS))
+		return ns;
+	unsigned shift = 63 - __builtin_clzll(ns) - HISTOGRAM_SUB_BITS;
+	return ((shift + 1) << HISTOGRAM_SUB_BITS) + ((ns >> shift) & ((1 << HISTOGRAM_SUB_BITS) - 1));
+}
+
+/* The highest value that would land in the bucket. */
+static inline uint64_t value_of(unsigned bucket)
+{
+	if (bucket < (1 << HISTOGRAM_SUB_BITS))
+		return bucket;
+	unsigned shift = (bucket >> HISTOGRAM_SUB_BITS) - 1;
+	uint64_t sub = bucket & ((1 << HISTOGRAM_SUB_BITS) - 1);
+	return (((1 << HISTOGRAM_SUB_BITS) + sub + 1) << shift) - 1;
+}
+
+void histogram_record(struct histogram * histogram, uint64_t ns)
+{
+	histogram->buckets[bucket_of(ns)]++;
+	histogram->count++;
+	if (ns > histogram->max)
+		histogram->max = ns;
+}
+
+uint64_t histogram_percentile(const struct histogram * histogram, double fraction)
+{
+	if (histogram->count == 0)
+		return 0;
+	uint64_t wanted = fraction * histogram->count;
+	if (wanted < 1)
+		wanted = 1;
+	uint64_t seen = 0;
+	for (register unsigned i = 0; i < HISTOGRAM_BUCKETS; i++){
+		seen += histogram->buckets[i];
+		if (seen >= wanted)
+			return value_of(i) < histogram->max ? value_of(i) : histogram->max;
+	}
+	return histogram->max;
+}
+
+void histogram_log(const struct histogram * histogram, const char * name)
+{
+	if (histogram->count == 0)
+		return;
+	logmsg(lp_info, lc_timing, "%s:  %llu samples; p50 %.3f µs, p99 %.3f µs, p99.9 %.3f µs, max %.3f µs.", name, (unsigned long long)histogram->count, histogram_percentile(histogram, 0.5) / 1e3, histogram_percentile(histogram, 0.99) / 1e3, histogram_percentile(histogram, 0.999) / 1e3, histogram->max / 1e3);
+}
+
+void timing_record(enum timing_phase phase, uint64_t ns)
+{
+	histogram_record(&phases[phase], ns);
+}
+
+/* For breaking startup down into its parts:  logs how long it's been since `*since`, then starts timing the next part from now. */
+void timing_lap(const char * what, uint64_t * since)
+{
+	uint64_t now = timing_now();
+	logmsg(lp_debug, lc_timing, "Startup:  %s took %.3f ms.", what, (now - *since) / 1e6);
+	*since = now;
+}
+
+void timing_dump(void)
+{
+	for (register int i = 0; i < tp_count; i++)
+		histogram_log(&phases[i], phase_names[i]);
+}
+
+/* Writing to the log isn't safe from inside a signal handler, so this just asks the main loop to do it. */
+void timing_signal([[maybe_unused]] int signo)
+{
+	timing_requested = 1;
+}
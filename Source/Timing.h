@@ -0,0 +1,56 @@
+/* LICENSE
+ *
+ * Copyright © 2021 Blue-Maned_Hawk.  All rights reserved.
+ *
+ * This software should have come with a file called LICENSE.  In case of any difference between this comment and that file, that file is the authority.  (If you did not recieve that file, it's a violation of the license.  Please report it to me.)
+ *
+ * This project is copylefted.  You may freely use, distribute, and modify this software, to the extent permitted by law, so long as you do not attempt to claim such activities are condoned by the author, you distribute the license file with any distributions of this software, you release any modifications under a similar license, and you do not attempt to claim that modified software is the original software.
+ *
+ * This license does not apply to software created with the API of this software (thought it does apply to the API itself); it also does not apply to any rule files, all of which must be placed in the public domain.
+ *
+ * This software links to zlib, which is under the zlib license, available at https://www.zlib.net/zlib_license.html.
+ *
+ * This software dynamically links to SDL2, which is under a separate instance of the zlib license, available at https://libsdl.org/license.php.
+ *
+ * This software dynamically links to libgcrypt, which is under the GNU LGPL2.1+, available at https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=COPYING;h=ccbbaf61b794c7aaea10dffb486095fdc8f3a44a;hb=HEAD.
+ *
+ * This license does not apply to trademarks or patents.
+ *
+ * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
+
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <stdint.h>
+#include <signal.h>
+
+/* Values under 16 ns get a bucket each; above that, every power of two is split into 16 buckets, so any value is recorded to within about 6%. */
+#define HISTOGRAM_SUB_BITS 4
+#define HISTOGRAM_BUCKETS ((64 - HISTOGRAM_SUB_BITS + 1) << HISTOGRAM_SUB_BITS)
+
+struct histogram {
+	uint64_t count;
+	uint64_t max;
+	uint64_t buckets[HISTOGRAM_BUCKETS];
+};
+
+enum timing_phase {
+	tp_events,
+	tp_tick,
+	tp_render,
+	tp_present,
+	tp_count
+};
+
+extern volatile sig_atomic_t timing_requested;
+
+extern uint64_t timing_now(void);
+extern void histogram_record(struct histogram * histogram, uint64_t ns);
+extern uint64_t histogram_percentile(const struct histogram * histogram, double fraction);
+extern void histogram_log(const struct histogram * histogram, const char * name);
+extern void timing_record(enum timing_phase phase, uint64_t ns);
+extern void timing_lap(const char * what, uint64_t * since);
+extern void timing_dump(void);
+extern void timing_signal(int signo);
+
+#endif/*ndef TIMING_H*/
@@ -0,0 +1,154 @@
+/* LICENSE
+ *
+ * Copyright © 2021 Blue-Maned_Hawk.  All rights reserved.
+ *
+ * This software should have come with a file called LICENSE.  In case of any difference between this comment and that file, that file is the authority.  (If you did not recieve that file, it's a violation of the license.  Please report it to me.)
+ *
+ * This project is copylefted.  You may freely use, distribute, and modify this software, to the extent permitted by law, so long as you do not attempt to claim such activities are condoned by the author, you distribute the license file with any distributions of this software, you release any modifications under a similar license, and you do not attempt to claim that modified software is the original software.
+ *
+ * This license does not apply to software created with the API of this software (thought it does apply to the API itself); it also does not apply to any rule files, all of which must be placed in the public domain.
+ *
+ * This software links to zlib, which is under the zlib license, available at https://www.zlib.net/zlib_license.html.
+ *
+ * This software dynamically links to SDL2, which is under a separate instance of the zlib license, available at https://libsdl.org/license.php.
+ *
+ * This software dynamically links to libgcrypt, which is under the GNU LGPL2.1+, available at https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=COPYING;h=ccbbaf61b794c7aaea10dffb486095fdc8f3a44a;hb=HEAD.
+ *
+ * This license does not apply to trademarks or patents.
+ *
+ * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
+
+/* This file keeps what programs log with `gake_log()` out of the way of the frame that they're logging from.  Each program has a ring of its own, the same kind of queue as the one in `Source/Logging.c`, and a message only costs the program formatting it into the ring; the logging thread comes by every time it wakes up, takes the messages back out, and writes them to the log like any other, under "API-Using Programs".
+ *
+ * A program that logs every frame of a headless run would be logging millions of messages a second, which is more than any log could keep, so each program is held to `trace_rate` messages a second by the generic cell rate algorithm, which is a token bucket that only needs one number:  the time at which the next message would be exactly on time.  A message that's more than `trace_burst` messages' worth early is dropped and counted, and so is one that finds the ring full, and the log says how many there were about once a second.  Either way, the program is never held up.
+ *
+ * When reading this file, you are expected to have access to and generally understand the following documents:
+ * 	· Latest draft of C2x:  http://www.open-std.org/JTC1/SC22/WG14/www/docs/n2596.pdf
+ * 	· The Clang compiler user(?) manual:  https://clang.llvm.org/docs/UsersManual.html
+ * 	· The latest POSIX specification:  https://pubs.opengroup.org/onlinepubs/9699919799/mindex.html
+ * 	· The Linux manpage for mmap(2), since `MAP_ANONYMOUS` isn't in POSIX.
+ * 	· Dmitry Vyukov's description of the queue:  https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue */
+
+#define _GNU_SOURCE /* For `MAP_ANONYMOUS`. */
+
+#include "Trace.h"
+#include "Logging.h"
+#include "Timing.h"
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+static const uint64_t interval_ns = 1000000000 / trace_rate;
+static const uint64_t tolerance_ns = (trace_burst - 1) * (1000000000 / trace_rate);
+
+/* The trace of the program that the thread is running for, set by whatever calls the program. */
+static _Thread_local struct trace * current;
+
+static void drain(struct log_source * source, bool last)
+{
+	struct trace * trace = (struct trace *)((char *)source - offsetof(struct trace, source));
+	struct trace_ring * ring = trace->ring;
+	for (;;){
+		struct trace_entry * entry = &ring->entries[trace->head % trace_entries];
+		if (atomic_load_explicit(&entry->sequence, memory_order_acquire) != trace->head + 1)
+			break;
+		/* An isolated program could have written anything here, so the message is copied out before it's looked at, and nothing about it is taken at its word.  Anything that isn't printable is turned into a question mark, so that a program can't put escape codes in the log or break a message across lines. */
+		char text[sizeof entry->text];
+		uint16_t length = entry->length < sizeof text ? entry->length : sizeof text;
+		memcpy(text, entry->text, length);
+		for (register uint16_t i = 0; i < length; i++){
+			unsigned char c = text[i];
+			if (c < ' ' || c == 0x7f)
+				text[i] = '?';
+		}
+		logmsg_at(entry->time_ns, lp_info, lc_apiprgm, "%s:  %.*s", trace->name, (int)length, text);
+		atomic_store_explicit(&entry->sequence, trace->head + trace_entries, memory_order_release);
+		trace->head++;
+	}
+	uint64_t now = timing_now();
+	if (now - trace->told_ns < 1000000000 && !last)
+		return;
+	uint64_t limited = atomic_load_explicit(&ring->limited, memory_order_relaxed);
+	uint64_t overflowed = atomic_load_explicit(&ring->overflowed, memory_order_relaxed);
+	if (limited != trace->limited_told)
+		logmsg_at(now, lp_note, lc_apiprgm, "Program %s logged too much, so %llu of its messages were dropped.", trace->name, (unsigned long long)(limited - trace->limited_told));
+	if (overflowed != trace->overflowed_told)
+		logmsg_at(now, lp_note, lc_apiprgm, "The log couldn't keep up with program %s, so %llu of its messages were dropped.", trace->name, (unsigned long long)(overflowed - trace->overflowed_told));
+	trace->limited_told = limited;
+	trace->overflowed_told = overflowed;
+	trace->told_ns = now;
+}
+
+/* This has to be called before the program's process is started, if it's isolated, so that the process has the same ring; and after `setup_logging()`.  Only the ring is shared with the process; the rest, which the logging thread follows pointers out of, is `malloc()`ed, so a program that scribbles over the ring can't do any more than garble its own messages.  `name` has to last as long as the game does.  Returns NULL if there's no memory for it, in which case whatever the program logs is ignored. */
+struct trace * trace_open(const char * name)
+{
+	struct trace * trace = malloc(sizeof *trace);
+	void * shared = mmap(NULL, sizeof (struct trace_ring), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (trace == NULL || shared == MAP_FAILED){
+		free(trace);
+		if (shared != MAP_FAILED)
+			munmap(shared, sizeof (struct trace_ring));
+		return NULL;
+	}
+	*trace = (struct trace){
+		.ring = shared,
+		.name = name,
+		.told_ns = timing_now(),
+		.source = { .drain = drain }
+	};
+	for (register uint32_t i = 0; i < trace_entries; i++)
+		atomic_init(&trace->ring->entries[i].sequence, i);
+	logging_add_source(&trace->source);
+	return trace;
+}
+
+/* Says which program the calling thread is about to run.  It's only a store, so it's fine to do before every call. */
+void trace_enter(struct trace * trace)
+{
+	current = trace;
+}
+
+/* The message goes in as it is; `drain()` cleans it up on the way out. */
+void trace_vlog(const char * format, va_list arg)
+{
+	if (current == NULL)
+		return;
+	struct trace_ring * trace = current->ring;
+	uint64_t now = timing_now();
+	uint64_t allowed_at = atomic_load_explicit(&trace->allowed_at, memory_order_relaxed);
+	for (;;){
+		uint64_t due = allowed_at > now ? allowed_at : now;
+		if (due - now > tolerance_ns){
+			atomic_fetch_add_explicit(&trace->limited, 1, memory_order_relaxed);
+			return;
+		}
+		if (atomic_compare_exchange_weak_explicit(&trace->allowed_at, &allowed_at, due + interval_ns, memory_order_relaxed, memory_order_relaxed))
+			break;
+	}
+
+	uint64_t position = atomic_load_explicit(&trace->tail, memory_order_relaxed);
+	struct trace_entry * entry;
+	for (;;){
+		entry = &trace->entries[position % trace_entries];
+		int64_t difference = (int64_t)(atomic_load_explicit(&entry->sequence, memory_order_acquire) - position);
+		if (difference == 0){
+			if (atomic_compare_exchange_weak_explicit(&trace->tail, &position, position + 1, memory_order_relaxed, memory_order_relaxed))
+				break;
+		} else if (difference < 0){
+			atomic_fetch_add_explicit(&trace->overflowed, 1, memory_order_relaxed);
+			return;
+		} else {
+			position = atomic_load_explicit(&trace->tail, memory_order_relaxed);
+		}
+	}
+	entry->time_ns = now;
+	int length = vsnprintf(entry->text, sizeof entry->text, format, arg);
+	entry->length = length < 0 ? 0 : (size_t)length < sizeof entry->text ? (size_t)length : sizeof entry->text - 1;
+	atomic_store_explicit(&entry->sequence, position + 1, memory_order_release);
+}
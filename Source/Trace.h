@@ -0,0 +1,63 @@
+/* LICENSE
+ *
+ * Copyright © 2021 Blue-Maned_Hawk.  All rights reserved.
+ *
+ * This software should have come with a file called LICENSE.  In case of any difference between this comment and that file, that file is the authority.  (If you did not recieve that file, it's a violation of the license.  Please report it to me.)
+ *
+ * This project is copylefted.  You may freely use, distribute, and modify this software, to the extent permitted by law, so long as you do not attempt to claim such activities are condoned by the author, you distribute the license file with any distributions of this software, you release any modifications under a similar license, and you do not attempt to claim that modified software is the original software.
+ *
+ * This license does not apply to software created with the API of this software (thought it does apply to the API itself); it also does not apply to any rule files, all of which must be placed in the public domain.
+ *
+ * This software links to zlib, which is under the zlib license, available at https://www.zlib.net/zlib_license.html.
+ *
+ * This software dynamically links to SDL2, which is under a separate instance of the zlib license, available at https://libsdl.org/license.php.
+ *
+ * This software dynamically links to libgcrypt, which is under the GNU LGPL2.1+, available at https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=COPYING;h=ccbbaf61b794c7aaea10dffb486095fdc8f3a44a;hb=HEAD.
+ *
+ * This license does not apply to trademarks or patents.
+ *
+ * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include "Logging.h"
+
+/* A program can log this many messages a second for as long as it likes, and up to `trace_burst` more all at once.  The ring has room for more than the logging thread can miss between two of its wakeups at that rate, so it only fills up if the logging thread falls behind. */
+enum { trace_rate = 1024, trace_burst = 128, trace_entries = 512, trace_entry_bytes = 256 };
+
+struct trace_entry {
+	_Atomic uint64_t sequence; /* The same as in `struct record` in `Source/Logging.c`. */
+	uint64_t time_ns; /* From `timing_now()`. */
+	uint16_t length;
+	char text[trace_entry_bytes - 18];
+};
+
+/* The messages that `gake_log()` has been given by one program and that haven't been written out yet, and everything that the program's side of the queue changes.  This is in memory of its own that's shared with the program's process, if it's isolated, so the program writes into it the same way either way; so nothing in here can be trusted by the game. */
+struct trace_ring {
+	_Alignas(64) _Atomic uint64_t tail; /* Written by every thread that the program logs from. */
+	_Alignas(64) _Atomic uint64_t allowed_at; /* The rate limit, as the time that the next message would be on time at; see `trace_vlog()`. */
+	_Atomic uint64_t limited; /* Messages dropped for going over the rate limit. */
+	_Atomic uint64_t overflowed; /* Messages dropped because the ring was full. */
+	struct trace_entry entries[trace_entries];
+};
+
+/* The logging thread's side of one program's queue.  This is the game's own memory, which an isolated program can't write to. */
+struct trace {
+	struct trace_ring * ring;
+	uint64_t head;
+	uint64_t limited_told;
+	uint64_t overflowed_told;
+	uint64_t told_ns;
+	const char * name;
+	struct log_source source;
+};
+
+extern struct trace * trace_open(const char * name);
+extern void trace_enter(struct trace * trace);
+extern void trace_vlog(const char * format, va_list arg);
+
+#endif/*ndef TRACE_H*/
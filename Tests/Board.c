@@ -0,0 +1,169 @@
+/* LICENSE
+ *
+ * Copyright © 2021 Blue-Maned_Hawk.  All rights reserved.
+ *
+ * This software should have come with a file called LICENSE.  In case of any difference between this comment and that file, that file is the authority.  (If you did not recieve that file, it's a violation of the license.  Please report it to me.)
+ *
+ * This project is copylefted.  You may freely use, distribute, and modify this software, to the extent permitted by law, so long as you do not attempt to claim such activities are condoned by the author, you distribute the license file with any distributions of this software, you release any modifications under a similar license, and you do not attempt to claim that modified software is the original software.
+ *
+ * This license does not apply to software created with the API of this software (thought it does apply to the API itself); it also does not apply to any rule files, all of which must be placed in the public domain.
+ *
+ * This software links to zlib, which is under the zlib license, available at https://www.zlib.net/zlib_license.html.
+ *
+ * This software dynamically links to SDL2, which is under a separate instance of the zlib license, available at https://libsdl.org/license.php.
+ *
+ * This software dynamically links to libgcrypt, which is under the GNU LGPL2.1+, available at https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=COPYING;h=ccbbaf61b794c7aaea10dffb486095fdc8f3a44a;hb=HEAD.
+ *
+ * This license does not apply to trademarks or patents.
+ *
+ * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
+
+/* This file checks what a snake looks like after it dies, and that it can follow its own tail around.  The snakes are set up by hand on a small board, then moved with `gake_simulate()`, which steps a copy of the board exactly as the game does and says how long the snake ended up.  It also checks that a snapshot of a copy only restores when it's given the whole of it, that an apple off the side of the board isn't taken for one on the next row, and that the smallest board there is can be played on.
+ *
+ * When reading this file, you are expected to have access to and generally understand the following documents:
+ * 	· Latest draft of C2x:  http://www.open-std.org/JTC1/SC22/WG14/www/docs/n2596.pdf
+ * 	· The latest POSIX specification:  https://pubs.opengroup.org/onlinepubs/9699919799/mindex.html */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "Board.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../gake.h"
+
+enum { side = 8 };
+
+static uint64_t occupancy[1];
+static uint32_t body[side * side];
+
+/* `cells` goes from the tail to the head, as `x`, `y` pairs.  The apple is out of the way in the bottom right corner. */
+static struct gake_curstate snake(const int (* cells)[2], uint32_t length, enum gake_direction direction)
+{
+	occupancy[0] = 0;
+	for (register uint32_t i = 0; i < length; i++){
+		body[i] = cells[i][1] * side + cells[i][0];
+		occupancy[0] |= (uint64_t)1 << body[i];
+	}
+	return (struct gake_curstate){
+		.version = GAKE_ABI_VERSION,
+		.size = sizeof (struct gake_curstate),
+		.width = side,
+		.height = side,
+		.head_x = cells[length - 1][0],
+		.head_y = cells[length - 1][1],
+		.apple_x = side - 1,
+		.apple_y = side - 1,
+		.length = length,
+		.direction = direction,
+		.alive = 1,
+		.occupancy = occupancy,
+		.body = body,
+		.body_mask = side * side - 1,
+		.body_head = length - 1,
+		.keys = ""
+	};
+}
+
+static bool check(const char * what, const struct gake_curstate * state, const enum gake_direction * moves, size_t count, bool alive, unsigned length)
+{
+	struct gake_newstate steps[8];
+	for (register size_t i = 0; i < count; i++)
+		steps[i].direction = moves[i];
+	struct gake_result result;
+	if (!gake_simulate(state, steps, count, &result)){
+		fprintf(stderr, "Board:  %s:  the snake couldn't be set up.\n", what);
+		return 0;
+	}
+	if (result.moves != count || result.alive != alive || result.length != length){
+		fprintf(stderr, "Board:  %s:  after %zu moves, the snake was %s with a length of %u, but it should have been %s with a length of %u after %zu.\n", what, result.moves, result.alive ? "alive" : "dead", result.length, alive ? "alive" : "dead", length, count);
+		return 0;
+	}
+	return 1;
+}
+
+static bool check_snapshot(const struct gake_curstate * state)
+{
+	struct gake_game * game = gake_clone(state);
+	if (game == NULL){
+		fprintf(stderr, "Board:  snapshots:  the snake couldn't be set up.\n");
+		return 0;
+	}
+	size_t size = gake_snapshot_size(game);
+	void * blob = malloc(size);
+	bool ok = blob != NULL;
+	if (ok){
+		gake_snapshot(game, blob);
+		gake_step(game, gake_down);
+		if (gake_restore(game, blob, size - 1)){
+			fprintf(stderr, "Board:  snapshots:  a snapshot that was a byte short was restored.\n");
+			ok = 0;
+		}
+		if (!gake_restore(game, blob, size)){
+			fprintf(stderr, "Board:  snapshots:  a whole snapshot couldn't be restored.\n");
+			ok = 0;
+		}
+		struct gake_curstate restored;
+		gake_describe(game, &restored);
+		if (restored.head_x != state->head_x || restored.head_y != state->head_y || restored.length != state->length){
+			fprintf(stderr, "Board:  snapshots:  the snake wasn't put back where it was.\n");
+			ok = 0;
+		}
+	}
+	free(blob);
+	gake_release(game);
+	return ok;
+}
+
+/* On a 3 by 3 board, the snake starts two cells long, with its head against the right edge. */
+static bool check_smallest(void)
+{
+	struct board board;
+	if (!board_init(&board, 3, 3, gake_plane, 1)){
+		fprintf(stderr, "Board:  the smallest board couldn't be set up.\n");
+		return 0;
+	}
+	bool ok = board.length == 2 && board.body[board.head] == 1 * 3 + 2 && board_step(&board, gake_up) && board.body[board.head] == 2;
+	if (!ok)
+		fprintf(stderr, "Board:  the snake on the smallest board didn't start where it should have, or couldn't move.\n");
+	board_free(&board);
+	return ok;
+}
+
+int main(void)
+{
+	bool ok = 1;
+
+	/* Along the middle row, facing right; going down, left, and up again runs into the segment just behind where the head was. */
+	const int straight[][2] = { { 1, 3 }, { 2, 3 }, { 3, 3 }, { 4, 3 }, { 5, 3 } };
+	struct gake_curstate state = snake(straight, 5, gake_right);
+	ok &= check("running into itself", &state, (const enum gake_direction[]){ gake_down, gake_left, gake_up }, 3, 0, 5);
+
+	state = snake(straight, 5, gake_right);
+	ok &= check("running into a wall", &state, (const enum gake_direction[]){ gake_up, gake_up, gake_up, gake_up }, 4, 0, 5);
+
+	/* Curled up in a square of four cells, with the head next to the tail; the head can go where the tail is leaving, over and over. */
+	const int curled[][2] = { { 1, 3 }, { 2, 3 }, { 2, 4 }, { 1, 4 } };
+	state = snake(curled, 4, gake_left);
+	ok &= check("following its tail", &state, (const enum gake_direction[]){ gake_up, gake_right, gake_down, gake_left, gake_up }, 5, 1, 4);
+
+	state = snake(straight, 5, gake_right);
+	ok &= check_snapshot(&state);
+
+	/* One past the end of the top row would be the first cell of the next row if the coordinates were only checked together. */
+	state = snake(straight, 5, gake_right);
+	state.apple_x = side;
+	state.apple_y = 0;
+	struct gake_game * game = gake_clone(&state);
+	if (game != NULL){
+		fprintf(stderr, "Board:  an apple off the right edge of the board was accepted.\n");
+		gake_release(game);
+		ok = 0;
+	}
+
+	ok &= check_smallest();
+
+	return !ok;
+}
@@ -0,0 +1,75 @@
+/* LICENSE
+ *
+ * Copyright © 2021 Blue-Maned_Hawk.  All rights reserved.
+ *
+ * This software should have come with a file called LICENSE.  In case of any difference between this comment and that file, that file is the authority.  (If you did not recieve that file, it's a violation of the license.  Please report it to me.)
+ *
+ * This project is copylefted.  You may freely use, distribute, and modify this software, to the extent permitted by law, so long as you do not attempt to claim such activities are condoned by the author, you distribute the license file with any distributions of this software, you release any modifications under a similar license, and you do not attempt to claim that modified software is the original software.
+ *
+ * This license does not apply to software created with the API of this software (thought it does apply to the API itself); it also does not apply to any rule files, all of which must be placed in the public domain.
+ *
+ * This software links to zlib, which is under the zlib license, available at https://www.zlib.net/zlib_license.html.
+ *
+ * This software dynamically links to SDL2, which is under a separate instance of the zlib license, available at https://libsdl.org/license.php.
+ *
+ * This software dynamically links to libgcrypt, which is under the GNU LGPL2.1+, available at https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=COPYING;h=ccbbaf61b794c7aaea10dffb486095fdc8f3a44a;hb=HEAD.
+ *
+ * This license does not apply to trademarks or patents.
+ *
+ * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
+
+/* This file checks that programs built against the `gake.h` from before `gake_main_v2()` still get the state the way they expect it, through `program_call()`:  every field where the old header had it, and nothing else.  It loads `Tests/Programs/OldHeader.so`, so it has to be run from the top of the tree, which `make check` does.
+ *
+ * When reading this file, you are expected to have access to and generally understand the following documents:
+ * 	· Latest draft of C2x:  http://www.open-std.org/JTC1/SC22/WG14/www/docs/n2596.pdf
+ * 	· The latest POSIX specification:  https://pubs.opengroup.org/onlinepubs/9699919799/mindex.html */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "Board.h"
+#include "Program.h"
+#include <dlfcn.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "../gake.h"
+
+int main(void)
+{
+	struct program_code code;
+	if (!program_open(&code, "Tests/Programs/OldHeader.so")){
+		fprintf(stderr, "Compat:  couldn't open Tests/Programs/OldHeader.so.\n");
+		return 1;
+	}
+	struct program program = {};
+	program_use(&program, &code);
+	const struct gake_curstate_v1 * seen = dlsym(code.table, "seen");
+	if (program.main != NULL || program.main_v1 == NULL || seen == NULL){
+		fprintf(stderr, "Compat:  the old program wasn't found to be an old program.\n");
+		return 1;
+	}
+
+	struct board board;
+	if (!board_init(&board, 17, 15, gake_plane, 1)){
+		fprintf(stderr, "Compat:  couldn't make a board.\n");
+		return 1;
+	}
+	struct gake_curstate state = { .keys = "x" };
+	bool ok = 1;
+	for (register int frame = 0; frame < 6 && board.alive; frame++){
+		board_describe(&board, &state, 0);
+		struct gake_newstate move = {};
+		program_call(&program, &state, &move);
+		if (seen->frame != state.frame || seen->width != state.width || seen->height != state.height || seen->head_x != state.head_x || seen->head_y != state.head_y || seen->apple_x != state.apple_x || seen->apple_y != state.apple_y || seen->length != state.length || seen->direction != state.direction || seen->alive != state.alive){
+			fprintf(stderr, "Compat:  on frame %d, the old program was given a different state from the board's.\n", frame);
+			ok = 0;
+		}
+		if (move.direction != (frame % 2 == 0 ? gake_down : gake_up)){
+			fprintf(stderr, "Compat:  on frame %d, the old program's move didn't come back.\n", frame);
+			ok = 0;
+		}
+		board_step(&board, move.direction);
+	}
+	board_free(&board);
+	dlclose(code.table);
+	return !ok;
+}
@@ -0,0 +1,95 @@
+/* LICENSE
+ *
+ * Copyright © 2021 Blue-Maned_Hawk.  All rights reserved.
+ *
+ * This software should have come with a file called LICENSE.  In case of any difference between this comment and that file, that file is the authority.  (If you did not recieve that file, it's a violation of the license.  Please report it to me.)
+ *
+ * This project is copylefted.  You may freely use, distribute, and modify this software, to the extent permitted by law, so long as you do not attempt to claim such activities are condoned by the author, you distribute the license file with any distributions of this software, you release any modifications under a similar license, and you do not attempt to claim that modified software is the original software.
+ *
+ * This license does not apply to software created with the API of this software (thought it does apply to the API itself); it also does not apply to any rule files, all of which must be placed in the public domain.
+ *
+ * This software links to zlib, which is under the zlib license, available at https://www.zlib.net/zlib_license.html.
+ *
+ * This software dynamically links to SDL2, which is under a separate instance of the zlib license, available at https://libsdl.org/license.php.
+ *
+ * This software dynamically links to libgcrypt, which is under the GNU LGPL2.1+, available at https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=COPYING;h=ccbbaf61b794c7aaea10dffb486095fdc8f3a44a;hb=HEAD.
+ *
+ * This license does not apply to trademarks or patents.
+ *
+ * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
+
+/* This file checks that leaving a game, by pressing Escape or by dying, lands on the menu and stays there until something's picked from it.  The frames go the same way as in `Source/Main.c`, drawn into a surface of their own, so no display is needed.
+ *
+ * When reading this file, you are expected to have access to and generally understand the following documents:
+ * 	· Latest draft of C2x:  http://www.open-std.org/JTC1/SC22/WG14/www/docs/n2596.pdf
+ * 	· The latest POSIX specification:  https://pubs.opengroup.org/onlinepubs/9699919799/mindex.html
+ * 	· The SDL2 wiki:  https://wiki.libsdl.org/ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "SDL.h"
+#include "Board.h"
+#include "State.h"
+#include <stdbool.h>
+#include <stdio.h>
+
+static SDL_Renderer * renderer;
+static SDL_Surface * assets[4];
+static enum state state = menu;
+static enum state last_state = menu;
+
+/* One frame of `main()`, with the mouse out of the way of the buttons. */
+static void frame(SDL_Keycode key, const struct board * board)
+{
+	if (state == menu && last_state != menu)
+		render_menu_reset();
+	last_state = state;
+	struct mouse nowhere = { 0, 0, 0 };
+	if (state == menu)
+		state = render_menu(nowhere, key, renderer, assets);
+	else if (state == game)
+		state = render_game(0, key, nowhere, renderer, assets, board);
+}
+
+/* Picks the game from the menu, then leaves it however `leave` says, and checks where it ends up for a few frames after. */
+static bool check(const char * what, SDL_Keycode leave, const struct board * board)
+{
+	frame(SDLK_RETURN, board);
+	frame(SDLK_UNKNOWN, board);
+	if (state != game){
+		fprintf(stderr, "Menu:  %s:  the game couldn't be picked from the menu.\n", what);
+		return 0;
+	}
+	frame(leave, board);
+	for (register int i = 0; i < 3; i++){
+		frame(SDLK_UNKNOWN, board);
+		if (state != menu){
+			fprintf(stderr, "Menu:  %s:  %d frames after leaving the game, it went to state %d instead of staying on the menu.\n", what, i + 1, (int)state);
+			return 0;
+		}
+	}
+	return 1;
+}
+
+int main(void)
+{
+	SDL_Surface * target = SDL_CreateRGBSurfaceWithFormat(0, 640, 480, 32, SDL_PIXELFORMAT_RGBA32);
+	renderer = target == NULL ? NULL : SDL_CreateSoftwareRenderer(target);
+	for (register int i = 0; i < 4; i++)
+		assets[i] = SDL_CreateRGBSurfaceWithFormat(0, 8, 8, 32, SDL_PIXELFORMAT_RGBA32);
+	struct board alive = {}, dead = {};
+	if (renderer == NULL || assets[3] == NULL || !board_init(&alive, 8, 8, gake_plane, 1) || !board_init(&dead, 8, 8, gake_plane, 1)){
+		fprintf(stderr, "Menu:  couldn't set up:  %s\n", SDL_GetError());
+		return 1;
+	}
+	dead.alive = 0;
+
+	bool ok = 1;
+	ok &= check("pressing Escape", SDLK_ESCAPE, &alive);
+	ok &= check("dying", SDLK_UNKNOWN, &dead);
+
+	render_cleanup();
+	board_free(&alive);
+	board_free(&dead);
+	return !ok;
+}
@@ -0,0 +1,58 @@
+/* LICENSE
+ *
+ * Copyright © 2021 Blue-Maned_Hawk.  All rights reserved.
+ *
+ * This software should have come with a file called LICENSE.  In case of any difference between this comment and that file, that file is the authority.  (If you did not recieve that file, it's a violation of the license.  Please report it to me.)
+ *
+ * This project is copylefted.  You may freely use, distribute, and modify this software, to the extent permitted by law, so long as you do not attempt to claim such activities are condoned by the author, you distribute the license file with any distributions of this software, you release any modifications under a similar license, and you do not attempt to claim that modified software is the original software.
+ *
+ * This license does not apply to software created with the API of this software (thought it does apply to the API itself); it also does not apply to any rule files, all of which must be placed in the public domain.
+ *
+ * This software links to zlib, which is under the zlib license, available at https://www.zlib.net/zlib_license.html.
+ *
+ * This software dynamically links to SDL2, which is under a separate instance of the zlib license, available at https://libsdl.org/license.php.
+ *
+ * This software dynamically links to libgcrypt, which is under the GNU LGPL2.1+, available at https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=COPYING;h=ccbbaf61b794c7aaea10dffb486095fdc8f3a44a;hb=HEAD.
+ *
+ * This license does not apply to trademarks or patents.
+ *
+ * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
+
+/* This is a program built against the `gake.h` from before `gake_main_v2()`, for `Tests/Compat.c`.  The part of that header that it needs is copied here exactly as it was, so this is built the way an old program would have been, whatever the current header says.  It keeps a copy of the last state it was given, for the test to look at, and goes down and up in turn. */
+
+#include <string.h>
+
+enum gake_direction {
+	gake_ahead = 0,
+	gake_up = 1,
+	gake_down = 2,
+	gake_left = 3,
+	gake_right = 4
+};
+
+struct gake_curstate {
+	long long frame;
+	int width;
+	int height;
+	int head_x;
+	int head_y;
+	int apple_x;
+	int apple_y;
+	unsigned length;
+	enum gake_direction direction;
+	_Bool alive;
+	const char keys[];
+};
+
+struct gake_newstate {
+	enum gake_direction direction;
+};
+
+/* The keys are `const`, so the state can't be assigned, only copied. */
+unsigned char seen[sizeof (struct gake_curstate)];
+
+struct gake_newstate gake_main(struct gake_curstate state)
+{
+	memcpy(seen, &state, sizeof state);
+	return (struct gake_newstate){ state.frame % 2 == 0 ? gake_down : gake_up };
+}
@@ -0,0 +1,289 @@
+/* LICENSE
+ *
+ * Copyright © 2021 Blue-Maned_Hawk.  All rights reserved.
+ *
+ * This software should have come with a file called LICENSE.  In case of any difference between this comment and that file, that file is the authority.  (If you did not recieve that file, it's a violation of the license.  Please report it to me.)
+ *
+ * This project is copylefted.  You may freely use, distribute, and modify this software, to the extent permitted by law, so long as you do not attempt to claim such activities are condoned by the author, you distribute the license file with any distributions of this software, you release any modifications under a similar license, and you do not attempt to claim that modified software is the original software.
+ *
+ * This license does not apply to software created with the API of this software (thought it does apply to the API itself); it also does not apply to any rule files, all of which must be placed in the public domain.
+ *
+ * This software links to zlib, which is under the zlib license, available at https://www.zlib.net/zlib_license.html.
+ *
+ * This software dynamically links to SDL2, which is under a separate instance of the zlib license, available at https://libsdl.org/license.php.
+ *
+ * This software dynamically links to libgcrypt, which is under the GNU LGPL2.1+, available at https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=COPYING;h=ccbbaf61b794c7aaea10dffb486095fdc8f3a44a;hb=HEAD.
+ *
+ * This license does not apply to trademarks or patents.
+ *
+ * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
+
+/* This file checks that a game played back from a replay ends up exactly where it did when it was recorded, on every topology, whether it was stepped one board at a time or in a batch.  Each game is played with random moves (mostly going straight, so that the snake gets to the edges), recorded to a file, then played back from that file and compared with the board that recorded it.
+ *
+ * Then it checks games that are recorded at the same time, so that their parts are mixed together in the file:  some long ones, which go around the board on a path through every cell so that they never die, with short ones started and finished in between, and one long one that's never finished, as if the game had crashed partway through it.  Each one has to play back the same, from the start and from partway through, and the unfinished one has to be there up to its last keyframe.
+ *
+ * When reading this file, you are expected to have access to and generally understand the following documents:
+ * 	· Latest draft of C2x:  http://www.open-std.org/JTC1/SC22/WG14/www/docs/n2596.pdf
+ * 	· The latest POSIX specification:  https://pubs.opengroup.org/onlinepubs/9699919799/mindex.html */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "Batch.h"
+#include "Board.h"
+#include "Playback.h"
+#include "Replay.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "../gake.h"
+
+enum { side = 9, games = 16, most_frames = 6000 };
+
+/* The mixed games:  `long_games` long ones, each played for `long_frames` frames (the last of which is never finished), and a short one every `short_every` frames. */
+enum { long_side = 16, long_games = 4, short_every = 1000, short_games = 13, mixed_games = long_games + short_games };
+static const long long long_frames[long_games] = { 5000, 9000, 13000, 11000 };
+
+static enum gake_direction random_move(uint64_t * rng)
+{
+	*rng = *rng * 6364136223846793005 + 1442695040888963407;
+	uint32_t roll = *rng >> 33;
+	return roll % 4 != 0 ? gake_ahead : (enum gake_direction)(roll / 4 % 4 + 1);
+}
+
+/* Game `game` of each topology is stepped one board at a time if it's even, and in a batch of one if it's odd. */
+static void play(struct replay_file * file, struct board * board, struct replay * replay, enum gake_topology topology, uint32_t game)
+{
+	uint64_t rng = game + 1;
+	if (game % 2 == 0){
+		board_init(board, side, side, topology, game);
+		replay_begin(file, replay, board, game, NULL);
+		for (register int frame = 0; frame < most_frames && board->alive; frame++){
+			board_step(board, random_move(&rng));
+			replay_frame(replay, board);
+		}
+		return;
+	}
+	struct batch batch;
+	batch_init(&batch, 1, side, side, topology, game, 0);
+	replay_begin(file, replay, &batch.boards[0], game, NULL);
+	for (register int frame = 0; frame < most_frames && batch.alive[0]; frame++){
+		batch_step(&batch, &(struct gake_newstate){ random_move(&rng) });
+		replay_frame(replay, &batch.boards[0]);
+	}
+	/* The board is handed over whole, so that the batch doesn't free it. */
+	*board = batch.boards[0];
+	batch.boards[0] = (struct board){};
+	batch_free(&batch);
+}
+
+/* Where the snake goes next to stay on a path through every cell:  right along the even rows and left along the odd ones, from column 1 to the far side, then back up column 0 from the bottom row.  The snake starts on the middle row facing right, which is already on the path. */
+static enum gake_direction around(const struct board * board)
+{
+	uint32_t cell = board->body[board->head];
+	int x = cell % long_side, y = cell / long_side;
+	if (x == 0)
+		return y == 0 ? gake_right : gake_up;
+	if (y % 2 == 0)
+		return x < long_side - 1 ? gake_right : gake_down;
+	return x > 1 ? gake_left : y < long_side - 1 ? gake_down : gake_left;
+}
+
+static bool same(const struct board * played, const struct board * recorded, const char * what)
+{
+	if (played->frames != recorded->frames || played->score != recorded->score || played->length != recorded->length || played->alive != recorded->alive || played->direction != recorded->direction || played->body[played->head] != recorded->body[recorded->head]){
+		fprintf(stderr, "Replay:  %s ended at cell %u after %lld frames when it was played back, but at cell %u after %lld frames when it was recorded.\n", what, played->body[played->head], played->frames, recorded->body[recorded->head], recorded->frames);
+		return 0;
+	}
+	return 1;
+}
+
+static bool make_file(char * filename, struct replay_file * file)
+{
+	int descriptor = mkstemp(filename);
+	if (descriptor < 0){
+		fprintf(stderr, "Replay:  couldn't make a file to record to.\n");
+		return 0;
+	}
+	close(descriptor);
+	if (!replay_open(file, filename)){
+		unlink(filename);
+		return 0;
+	}
+	return 1;
+}
+
+static bool check_topologies(void)
+{
+	char filename[] = "/tmp/gake-replay-test-XXXXXX";
+	static struct board boards[gake_sphere + 1][games];
+	struct replay_file file;
+	if (!make_file(filename, &file))
+		return 0;
+	for (register int topology = gake_plane; topology <= gake_sphere; topology++){
+		for (register uint32_t game = 0; game < games; game++){
+			struct replay replay = {};
+			play(&file, &boards[topology][game], &replay, topology, game);
+			replay_write(&replay, &boards[topology][game]);
+			replay_free(&replay);
+		}
+	}
+	replay_close(&file);
+
+	bool ok = 1;
+	struct replay_reader reader;
+	struct replay_cursor * cursor = calloc(1, sizeof *cursor);
+	if (cursor == NULL || !replay_map(&reader, filename) || !replay_seek(cursor, &reader, 0, 0)){
+		fprintf(stderr, "Replay:  couldn't read back the file that was recorded.\n");
+		unlink(filename);
+		return 0;
+	}
+	for (register int topology = gake_plane; topology <= gake_sphere; topology++){
+		for (register uint32_t game = 0; game < games; game++){
+			while (replay_step(cursor));
+			char what[64];
+			snprintf(what, sizeof what, "game %u on a %s", game, board_topology_name(topology));
+			ok &= same(&cursor->board, &boards[topology][game], what);
+			board_free(&boards[topology][game]);
+			if ((topology != gake_sphere || game != games - 1) && !replay_next(cursor)){
+				fprintf(stderr, "Replay:  the file ended early.\n");
+				ok = 0;
+				topology = gake_sphere;
+				break;
+			}
+		}
+	}
+	replay_done(cursor);
+	free(cursor);
+	replay_unmap(&reader);
+	unlink(filename);
+	return ok;
+}
+
+/* What a game in the mixed file should look like, by its number in the file. */
+struct expected {
+	struct board board;
+	long long frames; /* How long it should play back for, which is less than `board` for the one that was cut off. */
+	long long probe; /* A frame to jump to, and where the head was then. */
+	uint32_t probed;
+	uint64_t seed;
+};
+
+/* Goes through every game in order, then jumps into the middle of each long one and goes on to the next game from there. */
+static bool check_mixed_file(const struct replay_reader * reader, struct replay_cursor * cursor, const struct expected * expected, const char * how)
+{
+	bool ok = 1;
+	char what[96];
+	if (!replay_seek(cursor, reader, 0, 0)){
+		fprintf(stderr, "Replay:  %s, the first mixed game couldn't be found.\n", how);
+		return 0;
+	}
+	for (register uint32_t game = 0; game < mixed_games; game++){
+		while (replay_step(cursor));
+		snprintf(what, sizeof what, "%s, mixed game %u", how, game);
+		if (expected[game].frames != expected[game].board.frames){
+			if (cursor->board.frames != expected[game].frames || (long long)cursor->header.frames != expected[game].frames){
+				fprintf(stderr, "Replay:  %s was cut off after %lld frames, but it played back for %lld.\n", what, expected[game].frames, cursor->board.frames);
+				ok = 0;
+			}
+		} else {
+			ok &= same(&cursor->board, &expected[game].board, what);
+		}
+		if (game != mixed_games - 1 && !replay_next(cursor)){
+			fprintf(stderr, "Replay:  %s, the file ended early.\n", what);
+			return 0;
+		}
+	}
+	if (replay_next(cursor)){
+		fprintf(stderr, "Replay:  %s, there were more games than were recorded.\n", how);
+		ok = 0;
+	}
+	for (register uint32_t game = 0; game < mixed_games; game++){
+		if (expected[game].probe == 0)
+			continue;
+		snprintf(what, sizeof what, "%s, mixed game %u", how, game);
+		if (!replay_seek(cursor, reader, game, expected[game].probe) || cursor->board.frames != expected[game].probe || cursor->board.body[cursor->board.head] != expected[game].probed){
+			fprintf(stderr, "Replay:  %s wasn't where it should have been after jumping to frame %lld.\n", what, expected[game].probe);
+			ok = 0;
+			continue;
+		}
+		if (game != mixed_games - 1 && (!replay_next(cursor) || cursor->game != game + 1 || cursor->board.frames != 0 || cursor->header.seed != expected[game + 1].seed)){
+			fprintf(stderr, "Replay:  %s, the next game couldn't be found after jumping into it.\n", what);
+			ok = 0;
+		}
+	}
+	return ok;
+}
+
+static bool check_mixed(void)
+{
+	char filename[] = "/tmp/gake-replay-test-XXXXXX";
+	struct replay_file file;
+	if (!make_file(filename, &file))
+		return 0;
+	static struct expected expected[mixed_games];
+	struct board boards[long_games];
+	struct replay replays[long_games] = {};
+	for (register int i = 0; i < long_games; i++){
+		board_init(&boards[i], long_side, long_side, gake_plane, 100 + i);
+		replay_begin(&file, &replays[i], &boards[i], 100 + i, NULL);
+	}
+	uint32_t shorts = 0;
+	long long probed[long_games];
+	for (register long long frame = 1; frame <= long_frames[2]; frame++){
+		for (register int i = 0; i < long_games; i++){
+			if (frame > long_frames[i])
+				continue;
+			board_step(&boards[i], around(&boards[i]));
+			replay_frame(&replays[i], &boards[i]);
+			if (frame == long_frames[i] * 2 / 3)
+				probed[i] = boards[i].body[boards[i].head];
+			if (frame == long_frames[i] && i != long_games - 1){
+				replay_write(&replays[i], &boards[i]);
+				expected[replays[i].game] = (struct expected){ boards[i], frame, frame * 2 / 3, probed[i], 100 + i };
+				replay_free(&replays[i]);
+			}
+		}
+		if (frame % short_every == 0 && shorts < short_games){
+			struct board board;
+			struct replay replay = {};
+			play(&file, &board, &replay, gake_plane, shorts++);
+			replay_write(&replay, &board);
+			expected[replay.game] = (struct expected){ .board = board, .frames = board.frames, .seed = shorts - 1 };
+			replay_free(&replay);
+		}
+	}
+	/* The last long game is never finished, so the file should only have it up to its last keyframe. */
+	int cut = long_games - 1;
+	expected[replays[cut].game] = (struct expected){ boards[cut], long_frames[cut] / REPLAY_KEYFRAME_INTERVAL * REPLAY_KEYFRAME_INTERVAL, long_frames[cut] * 2 / 3, probed[cut], 100 + cut };
+	replay_free(&replays[cut]);
+	replay_close(&file);
+
+	bool ok = 1;
+	struct replay_reader reader;
+	struct replay_cursor * cursor = calloc(1, sizeof *cursor);
+	if (cursor == NULL || !replay_map(&reader, filename) || reader.entries == 0){
+		fprintf(stderr, "Replay:  couldn't read back the mixed file that was recorded.\n");
+		unlink(filename);
+		return 0;
+	}
+	ok &= check_mixed_file(&reader, cursor, expected, "with the index");
+	/* A file that was never closed doesn't have an index, so everything has to be found by reading through. */
+	reader.entries = 0;
+	ok &= check_mixed_file(&reader, cursor, expected, "without the index");
+	replay_done(cursor);
+	free(cursor);
+	replay_unmap(&reader);
+	unlink(filename);
+	for (register uint32_t game = 0; game < mixed_games; game++)
+		board_free(&expected[game].board);
+	return ok;
+}
+
+int main(void)
+{
+	bool ok = check_topologies();
+	ok &= check_mixed();
+	return !ok;
+}
@@ -0,0 +1,208 @@
+/* LICENSE
+ *
+ * Copyright © 2021 Blue-Maned_Hawk.  All rights reserved.
+ *
+ * This software should have come with a file called LICENSE.  In case of any difference between this comment and that file, that file is the authority.  (If you did not recieve that file, it's a violation of the license.  Please report it to me.)
+ *
+ * This project is copylefted.  You may freely use, distribute, and modify this software, to the extent permitted by law, so long as you do not attempt to claim such activities are condoned by the author, you distribute the license file with any distributions of this software, you release any modifications under a similar license, and you do not attempt to claim that modified software is the original software.
+ *
+ * This license does not apply to software created with the API of this software (thought it does apply to the API itself); it also does not apply to any rule files, all of which must be placed in the public domain.
+ *
+ * This software links to zlib, which is under the zlib license, available at https://www.zlib.net/zlib_license.html.
+ *
+ * This software dynamically links to SDL2, which is under a separate instance of the zlib license, available at https://libsdl.org/license.php.
+ *
+ * This software dynamically links to libgcrypt, which is under the GNU LGPL2.1+, available at https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=COPYING;h=ccbbaf61b794c7aaea10dffb486095fdc8f3a44a;hb=HEAD.
+ *
+ * This license does not apply to trademarks or patents.
+ *
+ * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
+
+/* This file is a tool for reading the binary logs that `gake -L` writes (see `Source/Binlog.h`).  It's run as
+ *
+ * 	LogRead.elf [-c <category>]… [-p <priority>] [-f <seconds>] [-t <seconds>] <log>
+ *
+ * and writes out the messages in the log as text, the same as the text log would have had them but with the time to the millisecond, leaving out any that aren't in one of the categories given with `-c` (if there are any), that are less important than `-p`, or that were logged before `-f` or after `-t` seconds from when the log was started.  Categories and priorities can be given by number or by name (`misc`, `debug`, `env`, `checks`, `api`, `apiprgm`, `timing`; `debug`, `info`, `note`, `warn`, `err`).  Since the messages are only formatted once they're known to be wanted, searching a long log is mostly just decompressing it.
+ *
+ * When reading this file, you are expected to have access to and generally understand the following documents:
+ * 	· Latest draft of C2x:  http://www.open-std.org/JTC1/SC22/WG14/www/docs/n2596.pdf
+ * 	· The Clang compiler user(?) manual:  https://clang.llvm.org/docs/UsersManual.html
+ * 	· The latest POSIX specification:  https://pubs.opengroup.org/onlinepubs/9699919799/mindex.html
+ * 	· The zlib manual:  https://zlib.net/manual.html */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "Binlog.h"
+#include "zlib.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+
+/* These are the same as in `Source/Logging.h` and `Source/Logging.c`. */
+static const char * const category_names[] = { "misc", "debug", "env", "checks", "api", "apiprgm", "timing" };
+static const char * const categories[] = {
+	"Miscellaneous",
+	"Debugging Systems",
+	"Environment",
+	"Runtime Checks",
+	"API",
+	"API-Using Programs",
+	"Timing"
+};
+static const char * const priority_names[] = { [1] = "debug", "info", "note", "warn", "err" };
+static const char * const priorities[] = { [1] = "DEBUG", "INFO", "NOTICE", "WARNING", "ERROR" };
+enum { category_count = sizeof categories / sizeof *categories, priority_count = sizeof priorities / sizeof *priorities };
+
+/* Format numbers are slots in a table in the game, so they're never very big. */
+enum { format_limit = 1 << 20 };
+
+struct format {
+	char * string;
+	char types[BINLOG_MAX_ARGUMENTS + 1];
+	bool usable;
+};
+
+/* Returns -1 if `name` isn't in `names` and isn't a number less than `count`. */
+static int lookup(const char * name, const char * const * names, int count)
+{
+	char * end;
+	long number = strtol(name, &end, 10);
+	if (*end == '\0' && end != name)
+		return number >= 0 && number < count ? number : -1;
+	for (register int i = 0; i < count; i++)
+		if (names[i] != NULL && strcasecmp(name, names[i]) == 0)
+			return i;
+	return -1;
+}
+
+/* The same as in `Source/Logging.c`:  the text log doesn't have escape codes, so this doesn't either.  Works in place. */
+static void strip_escapes(char * text)
+{
+	char * kept = text;
+	for (; *text != '\0'; text++){
+		if (*text != '\e'){
+			*kept++ = *text;
+			continue;
+		}
+		while (*text != '\0' && text[1] != '\0' && *text != 'm')
+			text++;
+	}
+	*kept = '\0';
+}
+
+int main(int argc, char ** argv)
+{
+	bool wanted_categories[category_count] = {};
+	bool any_categories = 0;
+	int lowest_priority = 0;
+	int64_t from_ns = INT64_MIN, to_ns = INT64_MAX;
+	for (int opt; (opt = getopt(argc, argv, "c:p:f:t:")) != -1;){
+		switch (opt){
+		case 'c':
+			{
+				int category = lookup(optarg, category_names, category_count);
+				if (category < 0){
+					fprintf(stderr, "There's no category %s.\n", optarg);
+					return 2;
+				}
+				wanted_categories[category] = 1;
+				any_categories = 1;
+			}
+			break;
+		case 'p':
+			if ((lowest_priority = lookup(optarg, priority_names, priority_count)) < 0){
+				fprintf(stderr, "There's no priority %s.\n", optarg);
+				return 2;
+			}
+			break;
+		case 'f':
+			from_ns = strtod(optarg, NULL) * 1e9;
+			break;
+		case 't':
+			to_ns = strtod(optarg, NULL) * 1e9;
+			break;
+		default:
+			fprintf(stderr, "Usage:  %s [-c <category>]… [-p <priority>] [-f <seconds>] [-t <seconds>] <log>\n", argv[0]);
+			return 2;
+		}
+	}
+	if (optind != argc - 1){
+		fprintf(stderr, "Usage:  %s [-c <category>]… [-p <priority>] [-f <seconds>] [-t <seconds>] <log>\n", argv[0]);
+		return 2;
+	}
+
+	gzFile log = gzopen(argv[optind], "rb");
+	struct binlog_header header;
+	if (log == NULL || gzread(log, &header, sizeof header) != sizeof header || memcmp(header.magic, "GAKEBLG", 8) != 0 || header.version != 1){
+		fprintf(stderr, "%s isn't a binary log from Gake.\n", argv[optind]);
+		return 1;
+	}
+	gzbuffer(log, 1 << 18);
+
+	struct format * formats = NULL;
+	uint32_t format_count = 0;
+	struct format text = { .string = "%s", .types = "s", .usable = 1 };
+	static uint8_t payload[UINT16_MAX + 1];
+	static char out[UINT16_MAX + 1];
+	struct binlog_entry entry;
+	int read;
+	while ((read = gzread(log, &entry, sizeof entry)) == sizeof entry){
+		if (gzread(log, payload, entry.length) != entry.length)
+			break;
+		if (entry.kind == bk_format){
+			if (entry.format >= format_limit)
+				continue;
+			if (entry.format >= format_count){
+				uint32_t count = entry.format + 1 > format_count * 2 ? entry.format + 1 : format_count * 2;
+				struct format * grown = realloc(formats, count * sizeof *formats);
+				if (grown == NULL){
+					fprintf(stderr, "Out of memory.\n");
+					return 1;
+				}
+				memset(grown + format_count, 0, (count - format_count) * sizeof *grown);
+				formats = grown;
+				format_count = count;
+			}
+			struct format * format = &formats[entry.format];
+			free(format->string);
+			if ((format->string = malloc(entry.length + 1)) == NULL){
+				fprintf(stderr, "Out of memory.\n");
+				return 1;
+			}
+			memcpy(format->string, payload, entry.length);
+			format->string[entry.length] = '\0';
+			format->usable = binlog_types(format->string, format->types);
+			continue;
+		}
+		if (entry.kind != bk_message)
+			continue;
+
+		int64_t since_ns = entry.time_ns - header.monotonic_ns;
+		if (since_ns < from_ns || since_ns > to_ns || entry.priority < lowest_priority || (any_categories && (entry.category >= category_count || !wanted_categories[entry.category])))
+			continue;
+		const struct format * format = entry.format == BINLOG_TEXT ? &text : entry.format < format_count ? &formats[entry.format] : NULL;
+		if (format == NULL || format->string == NULL || !format->usable){
+			printf("(a message with format %u, which isn't in the log)\n", entry.format);
+			continue;
+		}
+		binlog_format(out, sizeof out, format->string, format->types, payload, entry.length);
+		strip_escapes(out);
+
+		int64_t real_ns = header.realtime_ns + since_ns;
+		time_t seconds = real_ns / 1000000000;
+		struct tm broken_down;
+		char time_str[16];
+		if (localtime_r(&seconds, &broken_down) == NULL || strftime(time_str, sizeof time_str, "%T", &broken_down) == 0)
+			strcpy(time_str, "??:??:??");
+		printf("[%s.%03d] %s (%s:)  %s\n", time_str, (int)(real_ns / 1000000 % 1000), entry.priority > 0 && entry.priority < priority_count ? priorities[entry.priority] : "???????", entry.category < category_count ? categories[entry.category] : "???", out);
+	}
+	if (read != 0)
+		fprintf(stderr, "%s ends partway through a message.\n", argv[optind]);
+	gzclose(log);
+	return 0;
+}
@@ -0,0 +1,178 @@
+/* LICENSE
+ *
+ * Copyright © 2021 Blue-Maned_Hawk.  All rights reserved.
+ *
+ * This software should have come with a file called LICENSE.  In case of any difference between this comment and that file, that file is the authority.  (If you did not recieve that file, it's a violation of the license.  Please report it to me.)
+ *
+ * This project is copylefted.  You may freely use, distribute, and modify this software, to the extent permitted by law, so long as you do not attempt to claim such activities are condoned by the author, you distribute the license file with any distributions of this software, you release any modifications under a similar license, and you do not attempt to claim that modified software is the original software.
+ *
+ * This license does not apply to software created with the API of this software (thought it does apply to the API itself); it also does not apply to any rule files, all of which must be placed in the public domain.
+ *
+ * This software links to zlib, which is under the zlib license, available at https://www.zlib.net/zlib_license.html.
+ *
+ * This software dynamically links to SDL2, which is under a separate instance of the zlib license, available at https://libsdl.org/license.php.
+ *
+ * This software dynamically links to libgcrypt, which is under the GNU LGPL2.1+, available at https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=COPYING;h=ccbbaf61b794c7aaea10dffb486095fdc8f3a44a;hb=HEAD.
+ *
+ * This license does not apply to trademarks or patents.
+ *
+ * THIS PRODUCT COMES WITH ABSOLUTELY NO WARRANTY, IMPLIED OR EXPLICIT, TO THE EXTENT PERMITTED BY LAW.  THE AUTHOR DISCLAIMS ANY LIABILITY FOR ANY DAMAGES OF ANY KIND CAUSED BY THIS PRODUCT, TO THE EXTENT PERMITTED BY LAW.*/
+
+/* This file is a tool for building asset packs (see `Source/Pack.h`).  It's run as
+ *
+ * 	Pack.elf <output> <name>=<file>[@<x>,<y>,<w>,<h>]…
+ *
+ * and puts each file into the pack under its name.  PNGs are decoded here, once, so that the game never has to; a rectangle after the `@` takes just that part of the image, which is how one sheet of textures becomes one entry per texture.  Anything else goes in as it is.
+ *
+ * When reading this file, you are expected to have access to and generally understand the following documents:
+ * 	· Latest draft of C2x:  http://www.open-std.org/JTC1/SC22/WG14/www/docs/n2596.pdf
+ * 	· The Clang compiler user(?) manual:  https://clang.llvm.org/docs/UsersManual.html
+ * 	· The latest POSIX specification:  https://pubs.opengroup.org/onlinepubs/9699919799/mindex.html
+ * 	· The SDL2 wiki:  https://wiki.libsdl.org/ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "Pack.h"
+#include "SDL.h"
+#include "SDL2/SDL_image.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Everything in the pack starts on a boundary of this many bytes. */
+static const size_t alignment = 64;
+
+struct piece {
+	struct pack_entry entry;
+	uint8_t * data;
+};
+
+static bool ends_with(const char * string, const char * end)
+{
+	size_t length = strlen(string), end_length = strlen(end);
+	return length >= end_length && strcmp(string + length - end_length, end) == 0;
+}
+
+static bool read_raw(struct piece * piece, const char * filename)
+{
+	FILE * file = fopen(filename, "rb");
+	if (file == NULL)
+		return 0;
+	size_t allocated = 4096;
+	piece->data = malloc(allocated);
+	size_t got;
+	while (piece->data != NULL && (got = fread(piece->data + piece->entry.size, 1, allocated - piece->entry.size, file)) > 0){
+		piece->entry.size += got;
+		if (piece->entry.size == allocated)
+			piece->data = realloc(piece->data, allocated *= 2);
+	}
+	bool read = piece->data != NULL && !ferror(file);
+	fclose(file);
+	return read;
+}
+
+static bool read_image(struct piece * piece, const char * filename, const SDL_Rect * rect)
+{
+	SDL_Surface * loaded = IMG_Load(filename);
+	if (loaded == NULL)
+		return 0;
+	SDL_Surface * image = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+	SDL_FreeSurface(loaded);
+	if (image == NULL)
+		return 0;
+	SDL_Rect area = rect->w > 0 ? *rect : (SDL_Rect){ 0, 0, image->w, image->h };
+	if (area.x < 0 || area.y < 0 || area.w <= 0 || area.h <= 0 || area.x + area.w > image->w || area.y + area.h > image->h){
+		SDL_FreeSurface(image);
+		return 0;
+	}
+	piece->entry.format = pf_rgba32;
+	piece->entry.width = area.w;
+	piece->entry.height = area.h;
+	piece->entry.pitch = area.w * 4;
+	piece->entry.size = (uint64_t)piece->entry.pitch * area.h;
+	piece->data = malloc(piece->entry.size);
+	if (piece->data != NULL){
+		SDL_LockSurface(image);
+		for (register int y = 0; y < area.h; y++)
+			memcpy(piece->data + y * piece->entry.pitch, (const uint8_t *)image->pixels + (area.y + y) * image->pitch + area.x * 4, piece->entry.pitch);
+		SDL_UnlockSurface(image);
+	}
+	SDL_FreeSurface(image);
+	return piece->data != NULL;
+}
+
+int main(int argc, char ** argv)
+{
+	if (argc < 3){
+		fprintf(stderr, "Usage:  %s <output> <name>=<file>[@<x>,<y>,<w>,<h>]…\n", argv[0]);
+		return 1;
+	}
+	uint32_t count = argc - 2;
+	struct piece * pieces = calloc(count, sizeof *pieces);
+	if (pieces == NULL)
+		return 1;
+	uint64_t offset = sizeof (struct pack_header) + count * sizeof (struct pack_entry);
+	for (register uint32_t i = 0; i < count; i++){
+		char * spec = argv[i + 2];
+		char * equals = strchr(spec, '=');
+		if (equals == NULL || equals == spec || (size_t)(equals - spec) >= sizeof pieces[i].entry.name){
+			fprintf(stderr, "%s:  expected <name>=<file>, with a name of under %zu characters.\n", spec, sizeof pieces[i].entry.name);
+			return 1;
+		}
+		memcpy(pieces[i].entry.name, spec, equals - spec);
+		char * filename = equals + 1;
+		SDL_Rect rect = {};
+		char * at = strrchr(filename, '@');
+		if (at != NULL){
+			if (sscanf(at + 1, "%d,%d,%d,%d", &rect.x, &rect.y, &rect.w, &rect.h) != 4){
+				fprintf(stderr, "%s:  expected @<x>,<y>,<w>,<h>.\n", spec);
+				return 1;
+			}
+			*at = '\0';
+		}
+		bool read = ends_with(filename, ".png") ? read_image(&pieces[i], filename, &rect) : read_raw(&pieces[i], filename);
+		if (!read){
+			fprintf(stderr, "%s:  could not read this (%s).\n", filename, ends_with(filename, ".png") ? SDL_GetError() : "it might not exist");
+			return 1;
+		}
+		offset = (offset + alignment - 1) / alignment * alignment;
+		pieces[i].entry.offset = offset;
+		pieces[i].entry.checksum = pack_checksum(pieces[i].data, pieces[i].entry.size);
+		offset += pieces[i].entry.size;
+	}
+
+	struct pack_entry * index = calloc(count, sizeof *index);
+	if (index == NULL)
+		return 1;
+	for (register uint32_t i = 0; i < count; i++)
+		index[i] = pieces[i].entry;
+	struct pack_header header = {
+		.magic = "GAKEPAK",
+		.version = 1,
+		.entries = count,
+		.index_checksum = pack_checksum(index, count * sizeof *index)
+	};
+	FILE * output = fopen(argv[1], "wb");
+	if (output == NULL){
+		perror(argv[1]);
+		return 1;
+	}
+	bool written = fwrite(&header, sizeof header, 1, output) == 1 && fwrite(index, sizeof *index, count, output) == count;
+	uint64_t at = sizeof header + count * sizeof *index;
+	static const uint8_t padding[64] = {};
+	for (register uint32_t i = 0; written && i < count; i++){
+		written = fwrite(padding, 1, index[i].offset - at, output) == index[i].offset - at && fwrite(pieces[i].data, 1, index[i].size, output) == index[i].size;
+		at = index[i].offset + index[i].size;
+		free(pieces[i].data);
+	}
+	if (fclose(output) != 0 || !written){
+		fprintf(stderr, "%s:  could not write the pack.\n", argv[1]);
+		remove(argv[1]);
+		return 1;
+	}
+	free(index);
+	free(pieces);
+	return 0;
+}
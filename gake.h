@@ -1,8 +1,104 @@
+#ifndef GAKE_H
+#define GAKE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Which version of the interface this header describes.  The game puts its own version in `gake_curstate.version`. */
+#define GAKE_ABI_VERSION 5
+
+enum gake_direction {
+	gake_ahead = 0, /* Keep going the way the snake is already going. */
+	gake_up = 1,
+	gake_down = 2,
+	gake_left = 3,
+	gake_right = 4
+};
+
+/* What happens at the edges of the board, the same as Golly's bounded grids.  On a plane, they're walls.  On a torus, each edge leads to the opposite one.  A Klein bottle is a torus whose left and right edges are joined with a twist, so leaving through the right edge on row `y` comes back in through the left edge on row `height - 1 - y`; a cross-surface has both pairs of edges twisted like that.  A sphere has to be square:  its top edge is joined to its left edge and its bottom edge to its right edge, so leaving through the top in column `x` comes back in through the left edge on row `x`, going right. */
+enum gake_topology {
+	gake_plane = 0,
+	gake_torus = 1,
+	gake_klein_bottle = 2,
+	gake_cross_surface = 3,
+	gake_sphere = 4
+};
+
+/* What changed on the board in the step just before the program was called. */
+enum gake_change {
+	gake_tail_removed = 0,
+	gake_head_added = 1,
+	gake_apple_eaten = 2,
+	gake_apple_spawned = 3
+};
+
+struct gake_delta {
+	uint32_t cell; /* `y * width + x` */
+	enum gake_change change;
+};
+
+/* The game keeps one of these for each board, aligned to a cache line, and hands programs a pointer to it.  New fields only ever get added at the end, and `size` says how much of the structure the game filled in, so a program built against an older version of this header can still read everything it knows about. */
 struct gake_curstate {
+	_Alignas(64) uint32_t version;
+	uint32_t size;
 	long long frame;
-	const char keys[];
+	int width;
+	int height;
+	int head_x;
+	int head_y;
+	int apple_x;
+	int apple_y;
+	unsigned length;
+	enum gake_direction direction;
+	_Bool alive;
+	/* One bit per cell, row by row, 64 cells to a word:  cell `y * width + x` is bit `(y * width + x) % 64` of word `(y * width + x) / 64`.  NULL on boards of more than 4194304 cells, which use `chunks` instead. */
+	const uint64_t * occupancy;
+	/* The cells of the snake as a ring buffer:  `body[body_head]` is the head, and segment `i` behind it is `body[(body_head - i) & body_mask]`. */
+	const uint32_t * body;
+	uint32_t body_mask;
+	uint32_t body_head;
+	const char * keys; /* The keys pressed this frame, as a string. */
+	/* Only filled in for programs that define `gake_wants_deltas` to be 1; for everyone else, `deltas` is NULL.  There are at most four of them, and none on frame 0. */
+	const struct gake_delta * deltas;
+	uint32_t delta_count;
+	/* Since version 3, and only on boards of more than 4194304 cells:  the board split into squares of 64 by 64 cells, `chunk_columns` across, each one word per row.  The cell at `x`, `y` is bit `x % 64` of word `y % 64` of `chunks[(y / 64) * chunk_columns + x / 64]`, and a chunk is NULL if the snake isn't in it.  Otherwise, `chunks` is NULL. */
+	const uint64_t * const * chunks;
+	uint32_t chunk_columns;
+	enum gake_topology topology; /* Since version 4. */
 };
 
 struct gake_newstate {
-	int dummy;
+	enum gake_direction direction;
 };
+
+/* A program defines `gake_main_v2()`, which gets the state by pointer and writes its move into a slot that the game owns.  Programs built against the older header, which only define `gake_main()`, are still supported:  those get a copy of the state as that header laid it out, and return their move.  That structure isn't in this header, so new programs can't define `gake_main()`.  `gake_main_batch()` and `gake_wants_deltas` are optional; see gake-api(7). */
+extern void gake_main_v2(const struct gake_curstate * state, struct gake_newstate * move);
+extern const _Bool gake_wants_deltas;
+extern void gake_main_batch(const struct gake_curstate * states, struct gake_newstate * moves, size_t count);
+
+/* The rest of these are provided by the game, for programs that want to look ahead by playing copies of the game out.  A copy plays by exactly the same rules as the real thing.  A snapshot is a flat blob of `gake_snapshot_size()` bytes, which grows with the snake; restoring one is little more than a copy.  See gake-api(7). */
+struct gake_game;
+extern struct gake_game * gake_clone(const struct gake_curstate * state);
+extern void gake_release(struct gake_game * game);
+extern size_t gake_snapshot_size(const struct gake_game * game);
+extern void gake_snapshot(const struct gake_game * game, void * blob);
+extern _Bool gake_restore(struct gake_game * game, const void * blob, size_t size);
+extern _Bool gake_step(struct gake_game * game, enum gake_direction direction);
+extern void gake_describe(const struct gake_game * game, struct gake_curstate * state);
+
+/* What happened when `gake_simulate()` played some moves out. */
+struct gake_result {
+	size_t moves; /* How many of the moves were made; fewer than were given if the snake died or won first. */
+	_Bool alive;
+	unsigned apples;
+	unsigned length;
+	int head_x;
+	int head_y;
+};
+
+extern _Bool gake_simulate(const struct gake_curstate * state, const struct gake_newstate * moves, size_t count, struct gake_result * result);
+
+/* Writes a message to the game's log, formatted the same as `printf()`.  This only formats it into a buffer, so it's cheap enough to call every frame, but only so many messages a second are kept, and it does nothing on threads that the game didn't call the program on.  See gake-api(7). */
+extern void gake_log(const char * format, ...);
+
+#endif/*ndef GAKE_H*/